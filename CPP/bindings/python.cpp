@@ -0,0 +1,188 @@
+#include "Converter.h"
+#include "Utils.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <stdexcept>
+
+namespace py = pybind11;
+
+// Python bindings for the in-process converter API. Station series are exposed
+// as read-only NumPy views onto the Converter's own storage (kept alive through
+// the array base), and gridded blocks are written straight into NumPy memory.
+
+namespace {
+
+const VariableData& requireVariable(const Converter& converter, const std::string& varName) {
+    const VariableData* vd = converter.findVariable(varName);
+    if (!vd) throw py::key_error("Variable not loaded: " + varName);
+    return *vd;
+}
+
+size_t resolveCount(const GridSpec& grid, size_t timeStart, py::object timeCount) {
+    if (timeStart >= grid.nTime) throw py::index_error("timeStart is outside the time axis");
+    size_t available = grid.nTime - timeStart;
+    if (timeCount.is_none()) return available;
+    return std::min(available, timeCount.cast<size_t>());
+}
+
+}
+
+PYBIND11_MODULE(swat2netcdf, m) {
+    m.doc() = "SWAT+ weather to NetCDF converter";
+    m.attr("MISSING_VALUE") = Converter::kMissingValue;
+
+    py::class_<GridSpec>(m, "GridSpec")
+        .def(py::init<>())
+        .def_readwrite("minLat", &GridSpec::minLat)
+        .def_readwrite("maxLat", &GridSpec::maxLat)
+        .def_readwrite("minLon", &GridSpec::minLon)
+        .def_readwrite("maxLon", &GridSpec::maxLon)
+        .def_readwrite("resolution", &GridSpec::resolution)
+        .def_readwrite("nLat", &GridSpec::nLat)
+        .def_readwrite("nLon", &GridSpec::nLon)
+        .def_readwrite("startYear", &GridSpec::startYear)
+        .def_readwrite("startDay", &GridSpec::startDay)
+        .def_readwrite("stepsPerDay", &GridSpec::stepsPerDay)
+        .def_readwrite("nTime", &GridSpec::nTime)
+        .def_property_readonly("shape", [](const GridSpec& g) {
+            return py::make_tuple(g.nTime, g.nLat, g.nLon);
+        });
+
+    py::class_<Converter>(m, "Converter")
+        .def(py::init<const std::string&, const std::string&, const std::string&>(),
+             py::arg("region"), py::arg("txtInOutDir"), py::arg("convertedDir"))
+        .def("run", &Converter::run, py::call_guard<py::gil_scoped_release>(),
+             py::arg("climateResolution") = 0.25, py::arg("shapePath") = "", py::arg("stopDate") = "2500-12-31")
+        .def("readShapefile", &Converter::readShapefile, py::call_guard<py::gil_scoped_release>())
+        .def("loadStations", [](Converter& self) {
+            // Reloading would reallocate the series that earlier stationSeries() views point into
+            if (self.stationsLoaded()) throw std::runtime_error("Stations are already loaded; create a new Converter to reload.");
+            py::gil_scoped_release release;
+            self.processWeatherFiles();
+        })
+        .def("defineGrid", &Converter::defineGrid,
+             py::arg("resolution") = 0.25, py::arg("hasShapefile") = false)
+        .def("writeNetCDF", &Converter::createNetCDF, py::call_guard<py::gil_scoped_release>(),
+             py::arg("filename"), py::arg("grid"))
+        .def("writeShards", [](const Converter& self, const GridSpec& grid, const std::string& shardBy,
+                               const std::vector<std::string>& only) {
+            ShardSpec spec;
+            if (!parseShardSpec(shardBy, spec)) throw py::value_error("Invalid shard spec: " + shardBy);
+            py::gil_scoped_release release;
+            return self.writeShards(grid, spec, only);
+        }, py::arg("grid"), py::arg("shardBy") = "year", py::arg("only") = std::vector<std::string>{})
+        .def("convertTile", [](Converter& self, const std::string& tile, const std::string& layout,
+                               double resolution, const std::string& shapePath) {
+            TileSpec spec;
+            if (!layout.empty() && !parseTileLayout(layout, spec)) throw py::value_error("Invalid tile layout: " + layout);
+            if (!parseTileIndex(tile, spec)) throw py::value_error("Invalid tile: " + tile);
+            self.setTiling(spec);
+            py::gil_scoped_release release;
+            return self.convertTile(resolution, shapePath);
+        }, py::arg("tile"), py::arg("layout") = "", py::arg("resolution") = 0.25, py::arg("shapePath") = "",
+           "Convert tile 'i/N' (optionally of an 'RxC' layout) to <region>_tile<i>of<N>.nc4.")
+        .def("mergeTiles", &Converter::mergeTiles, py::call_guard<py::gil_scoped_release>(), py::arg("count"))
+        .def("writeStationList", &Converter::createStationListFile, py::call_guard<py::gil_scoped_release>())
+        .def("setInterpolation", [](Converter& self, const std::string& mode) {
+            InterpolationMode parsed;
+            if (!parseInterpolationMode(mode, parsed)) throw py::value_error("Unknown interpolation mode: " + mode);
+            self.setInterpolation(parsed);
+        }, py::arg("mode"), "Gridding mode: 'none', 'nearest' or 'idw'.")
+        .def("setPacking", &Converter::setPacking, py::arg("pack") = true,
+             "Write variables as int16 with CF scale_factor/add_offset.")
+        .def("setMaxMemory", [](Converter& self, const std::string& size) {
+            size_t bytes = 0;
+            if (!parseMemorySize(size, bytes)) throw py::value_error("Invalid memory size: " + size);
+            self.setMaxMemory(bytes);
+        }, py::arg("size"), "Budget for station series in run(), e.g. '8G'; larger inputs spill to a scratch file.")
+        .def("setVariables", [](Converter& self, const std::vector<std::string>& groups) {
+            for (const auto& group : groups) {
+                std::vector<std::string> parsed;
+                if (!Utils::parseVariableList(group, parsed) || parsed.size() != 1) throw py::value_error("Unknown variable group: " + group);
+            }
+            self.setVariables(groups);
+        }, py::arg("groups"), "Weather groups loadStations() reads, e.g. ['pcp', 'tmp']; an empty list reads all.")
+        .def("setIoBackend", [](Converter& self, const std::string& backend) {
+            IoBackend parsed;
+            if (!parseIoBackend(backend, parsed)) throw py::value_error("Unknown I/O backend: " + backend);
+            self.setIoBackend(parsed);
+        }, py::arg("backend"), "Station file reads: 'auto', 'uring' or 'posix'.")
+        .def("applyQualityControl", [](Converter& self, const std::string& action, std::vector<double> sentinels) {
+            QualityOptions options;
+            if (!parseRangeAction(action, options.action)) throw py::value_error("Unknown QA action: " + action);
+            options.sentinels = std::move(sentinels);
+            self.setQualityControl(options);
+            py::dict report;
+            for (const auto& s : self.applyQualityControl()) {
+                report[py::str(s.name)] = py::dict(
+                    py::arg("values") = s.values, py::arg("sentinels") = s.sentinels, py::arg("missing") = s.missing,
+                    py::arg("belowRange") = s.belowRange, py::arg("aboveRange") = s.aboveRange,
+                    py::arg("inconsistent") = s.inconsistent, py::arg("min") = s.min, py::arg("max") = s.max);
+            }
+            return report;
+        }, py::arg("action") = "flag", py::arg("sentinels") = std::vector<double>{-99.0, -999.0},
+           "Normalize sentinels and range-check the loaded series in place; returns per-variable counts.")
+        .def("derivePet", [](Converter& self, const std::string& method) {
+            PetMethod parsed;
+            if (!parsePetMethod(method, parsed)) throw py::value_error("Unknown PET method: " + method);
+            py::gil_scoped_release release;
+            return self.derivePet(parsed);
+        }, py::arg("method") = "hargreaves", "Compute the pet variable from loaded temperature series.")
+        .def("variables", [](const Converter& self) {
+            std::vector<std::string> names;
+            for (const auto& vd : self.weatherData()) names.push_back(vd.name);
+            return names;
+        })
+        .def("stations", [](const Converter& self, const std::string& varName) {
+            py::list result;
+            for (const auto& st : requireVariable(self, varName).stations) {
+                py::dict d;
+                d["name"] = st.name;
+                d["lat"] = st.lat;
+                d["lon"] = st.lon;
+                d["elev"] = st.elev;
+                d["startYear"] = st.startYear;
+                d["startDay"] = st.startDay;
+                d["startStep"] = st.startStep;
+                d["stepsPerDay"] = st.stepsPerDay;
+                result.append(d);
+            }
+            return result;
+        }, py::arg("varName"))
+        .def("stationSeries", [](py::object self, const std::string& varName) {
+            const Converter& converter = self.cast<const Converter&>();
+            py::list result;
+            for (const auto& st : requireVariable(converter, varName).stations) {
+                py::array_t<double> view({st.data.size()}, {sizeof(double)}, st.data.data(), self);
+                view.attr("setflags")(py::arg("write") = false);
+                result.append(view);
+            }
+            return result;
+        }, py::arg("varName"),
+           "Read-only views onto each station's series; valid while the Converter is alive and not reloaded.")
+        .def("grid", [](const Converter& self, const std::string& varName, const GridSpec& grid,
+                        size_t timeStart, py::object timeCount) {
+            requireVariable(self, varName);
+            size_t count = resolveCount(grid, timeStart, timeCount);
+            auto* block = new std::vector<float>(count * grid.cellCount());
+            py::capsule owner(block, [](void* p) { delete static_cast<std::vector<float>*>(p); });
+            {
+                py::gil_scoped_release release;
+                self.gridVariable(varName, grid, timeStart, count, block->data());
+            }
+            return py::array_t<float>({count, (size_t)grid.nLat, (size_t)grid.nLon}, block->data(), owner);
+        }, py::arg("varName"), py::arg("grid"), py::arg("timeStart") = 0, py::arg("timeCount") = py::none())
+        .def("gridInto", [](const Converter& self, const std::string& varName, const GridSpec& grid,
+                            py::array_t<float, py::array::c_style> out, size_t timeStart) {
+            requireVariable(self, varName);
+            if (out.ndim() != 3 || out.shape(1) != grid.nLat || out.shape(2) != grid.nLon) {
+                throw py::value_error("Output buffer must be a C-contiguous float32 array of shape (t, nLat, nLon)");
+            }
+            size_t count = resolveCount(grid, timeStart, py::int_(out.shape(0)));
+            float* dst = out.mutable_data();
+            py::gil_scoped_release release;
+            return self.gridVariable(varName, grid, timeStart, count, dst);
+        }, py::arg("varName"), py::arg("grid"), py::arg("out").noconvert(), py::arg("timeStart") = 0,
+           "Grid into a caller-supplied float32 array without allocating. Returns the number of time steps written.");
+}
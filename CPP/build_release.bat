@@ -46,7 +46,7 @@ REM ==========================================
 REM 3. Install Dependencies
 REM ==========================================
 echo Installing Dependencies via vcpkg...
-"%VCPKG_ROOT%\vcpkg.exe" install netcdf-cxx4:%TRIPLET% gdal:%TRIPLET%
+"%VCPKG_ROOT%\vcpkg.exe" install netcdf-cxx4:%TRIPLET% gdal:%TRIPLET% zlib:%TRIPLET%
 if %ERRORLEVEL% NEQ 0 (
     echo Error installing dependencies.
     exit /b %ERRORLEVEL%
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+// Reader for TxtInOut folders shipped as .tar, .tar.gz/.tgz or .zip archives.
+//
+// Entries are decompressed in archive order in one sequential pass and handed
+// to the caller as whole in-memory files; nothing is extracted to disk. Tar
+// streams are inflated as they are read; zip archives are read through their
+// central directory, in the order their entries are stored.
+namespace Archive {
+    // True if `path` is a regular file named *.tar, *.tar.gz, *.tgz or *.zip
+    bool isArchive(const std::string& path);
+
+    // Calls onEntry(name, content) for every regular file, where name is the path inside
+    // the archive. Returns false if the archive is unreadable or truncated (reported on
+    // stderr); entries before the damage have already been delivered.
+    bool read(const std::string& path, const std::function<void(const std::string&, std::string&)>& onEntry);
+}
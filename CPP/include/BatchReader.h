@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Options.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Whole-file reader for large numbers of small station files.
+//
+// Files are opened and read in batches so that per-file latency (one round
+// trip per open/read on network filesystems) overlaps instead of adding up.
+// On Linux the io_uring backend submits a whole batch of opens, then a whole
+// batch of reads, with one system call each. Where io_uring is not compiled
+// in or not permitted at runtime, the posix backend opens the batch and
+// issues posix_fadvise(WILLNEED) on every file before reading any of them.
+namespace BatchReader {
+    // Backend `requested` resolves to on this system: IoBackend::Uring or IoBackend::Posix
+    IoBackend resolve(IoBackend requested);
+    // "io_uring" or "posix", for messages
+    std::string backendName(IoBackend requested);
+
+    // Calls onFile(index, content) for every path, in input order. Unreadable
+    // files are reported on stderr and skipped.
+    void readFiles(const std::vector<std::string>& paths,
+                   const std::function<void(size_t, std::string&)>& onFile,
+                   IoBackend backend = IoBackend::Auto, size_t batchSize = 256);
+}
@@ -3,7 +3,16 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <netcdf>
+#include <cmath>
+#include "Options.h"
+#include "Variables.h"
+#include <array>
+#include <memory>
+
+class SpillStore;
+class StationInterpolator;
+struct ServeRequest;
+struct ServeReply;
 
 struct Station {
     int id;
@@ -13,27 +22,101 @@ struct Station {
     double elev;
     int startYear = -1;
     int startDay = -1;
+    int startStep = 0;   // 0-based step of the first value within its day
+    int stepsPerDay = 1; // 24 for hourly records
     std::vector<double> data; // Time series data
 };
 
 struct VariableData {
-    std::string name; // e.g., "pcp", "tmp_max", "tmp_min"
+    VariableId id;
+    std::string name; // e.g., "pcp", "tmax", "tmin"
     std::string unit;
     std::vector<Station> stations;
 };
 
+// Output grid and time axis shared by every variable of one conversion.
+// Time index 0 is the first step of (startYear, startDay); there are
+// stepsPerDay steps per day (1 = daily, 24 = hourly).
+struct GridSpec {
+    double minLat = 0, maxLat = 0, minLon = 0, maxLon = 0;
+    double resolution = 0.25;
+    int nLat = 0;
+    int nLon = 0;
+    int startYear = -1;
+    int startDay = -1;
+    int stepsPerDay = 1;
+    size_t nTime = 0;
+
+    size_t cellCount() const { return static_cast<size_t>(nLat) * nLon; }
+};
+
+// Index on the grid's time axis of a station's first value
+long stationOffset(const Station& station, const GridSpec& grid);
+
 class Converter {
 public:
+    static constexpr float kMissingValue = Variables::kFillValue;
+
     Converter(const std::string& region, const std::string& txtInOutDir, const std::string& convertedDir);
-    
+    ~Converter();
+
     void run(double climateResolution, const std::string& shapePath, const std::string& stopDate);
 
+    // In-process API (used by run() and the Python bindings)
+    void readShapefile(const std::string& shapePath);
+    void processWeatherFiles();
+    GridSpec defineGrid(double resolution, bool hasShapefile) const;
+    size_t gridVariable(const std::string& varName, const GridSpec& grid, size_t timeStart, size_t timeCount, float* out) const;
+    void createNetCDF(const std::string& filename, const GridSpec& grid) const;
+    void createStationListFile() const;
+    // Writes <region>_<label>.nc4 per time shard (concurrently) plus a <region>.ncml index.
+    // With `only` non-empty, just those shard labels are (re)written.
+    bool writeShards(const GridSpec& grid, const ShardSpec& spec, const std::vector<std::string>& only = {}) const;
+    void setInterpolation(InterpolationMode mode) { m_interpolation = mode; }
+    void setIoBackend(IoBackend backend) { m_ioBackend = backend; }
+    // Weather groups to convert (pcp, tmp, slr, hmd, wnd, pet); files of other groups are never opened.
+    // Empty = every group found in the input directory.
+    void setVariables(const std::vector<std::string>& groups) { m_variables = groups; }
+    // Narrows the selection after loading and drops the series of groups no longer selected
+    // (stations of an archive keep their coordinates for netcdf.ncw)
+    void restrictVariables(const std::vector<std::string>& groups);
+    // Without setVariables: converts the groups on the climate line of the archive's file.cio,
+    // applied as soon as file.cio is reached so that later station entries of other groups are skipped
+    void selectClimateVariables() { m_climateSelection = true; }
+    const std::vector<std::string>& variables() const { return m_variables; }
+    bool isSelected(const std::string& group) const;
+    void setPacking(bool pack) { m_pack = pack; }
+    // Converts only tile spec.index of the layout set with setTiling to <region>_tile<i>of<N>.nc4,
+    // reading just the stations that tile's cells use
+    void setTiling(const TileSpec& spec) { m_tileSpec = spec; }
+    bool convertTile(double climateResolution, const std::string& shapePath);
+    // Merges <region>_tile<i>of<N>.nc4 (i = 1..count) into <region>.nc4 and removes the tile files
+    bool mergeTiles(int count);
+    // Writes one --serve request (grid, window and variable subset) from the loaded stations,
+    // always inside the output directory. Const and safe to call from several threads at once.
+    bool writeRequest(const ServeRequest& request, ServeReply& reply) const;
+    // Budget for station series in bytes (0 = unlimited). Larger inputs are spilled to a scratch file.
+    void setMaxMemory(size_t bytes) { m_maxMemory = bytes; }
+    void setSharding(const ShardSpec& spec, const std::vector<std::string>& only = {}) { m_shardSpec = spec; m_onlyShards = only; }
+    void setQualityControl(const QualityOptions& options) { m_qualityOptions = options; m_qualityEnabled = true; }
+    std::vector<VariableQaStats> applyQualityControl();
+    void setPetMethod(PetMethod method) { m_petMethod = method; m_derivePet = true; }
+    bool derivePet(PetMethod method);
+
+    const std::vector<VariableData>& weatherData() const { return m_weatherData; }
+    // True once processWeatherFiles() has run; loading again would duplicate every station
+    bool stationsLoaded() const { return m_stationsLoaded; }
+    // Files of an archive input other than station files (file.cio, weather-sta.cli, ...) by file
+    // name, kept by processWeatherFiles() for the model file copy
+    const std::map<std::string, std::string>& archiveFiles() const { return m_archiveFiles; }
+    const VariableData* findVariable(const std::string& varName) const;
+
 private:
     std::string m_region;
     std::string m_txtInOutDir;
     std::string m_convertedDir;
     double m_resolution;
-    
+
     // Bounding box
     double m_minLat, m_maxLat, m_minLon, m_maxLon;
 
@@ -42,10 +125,79 @@ private:
     int m_startDay = -1;
 
     std::vector<VariableData> m_weatherData;
+    bool m_stationsLoaded = false;
 
-    void processWeatherFiles();
-    void readStationFile(const std::string& filepath, const std::string& varName, const std::string& unit, int valueColumnIndex = 0);
-    void createNetCDF(const std::string& filename);
-    void readShapefile(const std::string& shapePath);
-    void createStationListFile();
+    // Archive input (txtInOutDir is a .zip/.tar.gz file): everything is read in one pass
+    std::map<std::string, std::string> m_archiveFiles;
+    std::map<std::string, Station> m_archiveStations; // coordinates of station files of unselected groups
+    bool m_climateSelection = false;
+
+    InterpolationMode m_interpolation = InterpolationMode::None;
+    IoBackend m_ioBackend = IoBackend::Auto;
+    std::vector<std::string> m_variables;
+
+    bool m_pack = false;
+
+    size_t m_maxMemory = 0;
+    std::unique_ptr<SpillStore> m_spill;
+    std::array<size_t, Variables::kVariableCount> m_spilled{}; // stations per variable already in the scratch file
+    std::vector<VariableQaStats> m_spillQaStats; // QA totals accumulated over spilled blocks
+    GridSpec m_spillAxis;
+
+    TileSpec m_tileSpec;
+    double m_referenceLat = NAN; // projection latitude of the full grid when converting one tile
+
+    ShardSpec m_shardSpec;
+    std::vector<std::string> m_onlyShards;
+
+    bool m_qualityEnabled = false;
+    QualityOptions m_qualityOptions;
+
+    bool m_derivePet = false;
+    PetMethod m_petMethod = PetMethod::Hargreaves;
+
+    using FileGroups = std::map<WeatherGroup, std::vector<std::string>>;
+
+    // Coordinates and record span of a station file, from its header and first/last data lines
+    struct StationHeader {
+        std::string path;
+        double lat = 0, lon = 0;
+        int startYear = -1, startDay = -1;
+        int startStep = 0, stepsPerDay = 1;
+        size_t count = 0; // values in the record, one time step each (as readStationFile stores them)
+    };
+
+    using HeaderMap = std::map<WeatherGroup, std::vector<StationHeader>>;
+
+    FileGroups weatherFileGroups() const;
+    void loadWeatherFiles(const FileGroups& groups);
+    void loadArchive();
+    // Contents of a TxtInOut file that is not a station file, from the input directory or archive
+    bool readInputFile(const std::string& name, std::string& content) const;
+    bool readStationHeader(const std::string& path, StationHeader& header) const;
+    // Full grid with the time axis taken from the station headers (no series are parsed)
+    GridSpec headerGrid(const FileGroups& groups, HeaderMap& headers, bool hasShapefile);
+    bool loadOutOfCore(bool hasShapefile, GridSpec& grid);
+    void spillStations(WeatherGroup group, bool final);
+    void reportQualityControl(const std::vector<VariableQaStats>& stats) const;
+    static bool shapefileExtent(const std::string& shapePath, double& minLat, double& maxLat, double& minLon, double& maxLon);
+    // Sets the time axis of a grid to span every loaded station record
+    void setTimeAxis(GridSpec& grid) const;
+    std::vector<bool> tileStations(const std::vector<StationHeader>& headers, const GridSpec& grid, const GridSpec& local) const;
+    // Parses one station file of `group` into a station of each of the group's variables
+    void readStationFile(const std::string& filepath, const std::string& content, const GroupDescriptor& group);
+    bool isSelected(WeatherGroup group) const;
+    VariableData* variableData(VariableId id);
+    const VariableData* variableData(VariableId id) const;
+    // Per-variable state shared by every file written from one grid (src/WriteContext.h)
+    struct WriteContext;
+
+    bool validateGrid(const GridSpec& grid) const;
+    WriteContext prepareWrite(const GridSpec& grid, const std::vector<VariableId>& variables = {}) const;
+    bool writeTimeRange(const std::string& filename, const GridSpec& grid, size_t timeStart, size_t timeCount,
+                        const WriteContext& context, bool verbose) const;
+    std::vector<long> stationOffsets(const VariableData& vd, const GridSpec& grid) const;
+    size_t gridStations(const VariableData& vd, const GridSpec& grid, size_t timeStart, size_t timeCount, float* out) const;
+    size_t interpolateStations(const VariableData& vd, const StationInterpolator& interpolator, const GridSpec& grid, size_t timeStart, size_t timeCount, float* out,
+                               size_t maxThreads = 0) const;
 };
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Options.h"
+#include <string>
+#include <vector>
+
+struct VariableData;
+
+namespace Evapotranspiration {
+    // Extraterrestrial radiation (FAO-56 eq. 21) in MJ/m2/day
+    double extraterrestrialRadiation(double latitudeDeg, int dayOfYear);
+
+    // Per-series kernels. Inputs equal to `fill` produce `fill` in pet.
+    void hargreaves(const double* tmax, const double* tmin, const double* ra, size_t n, double fill, double* pet);
+    void priestleyTaylor(const double* tmax, const double* tmin, const double* slr, const double* hmd,
+                         const double* ra, double elevation, size_t n, double fill, double* pet);
+
+    // Builds a "pet" variable from the loaded tmax/tmin (and slr/hmd for
+    // Priestley-Taylor), one station per temperature station, computed in
+    // parallel across stations. Sub-daily temperature stations get an empty
+    // series. Returns false if temperature is not loaded.
+    bool derive(const std::vector<VariableData>& weatherData, PetMethod method, VariableData& pet);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Options.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Station;
+struct GridSpec;
+
+// Precomputed cell -> station weights for one variable on one grid.
+// Neighbours are found once with a KD-tree over the station coordinates and
+// stored as a fixed-width sparse matrix (k entries per cell, nearest first), so
+// each time step is a single sparse matrix-vector product. Stations without a
+// value on a given day are skipped and the remaining weights renormalized; in
+// nearest mode a cell whose k neighbours are all missing searches further out.
+class StationInterpolator {
+public:
+    // referenceLat fixes the projection (default: grid centre) so that a tile of a
+    // larger grid picks the same neighbours and weights as the full grid would.
+    StationInterpolator(const std::vector<Station>& stations, const GridSpec& grid, InterpolationMode mode,
+                        int neighbours = 8, double power = 2.0, double referenceLat = NAN);
+
+    // stationValues holds one value per station (Converter::kMissingValue when absent).
+    // out receives grid.cellCount() values.
+    void apply(const float* stationValues, float* out) const;
+
+    size_t neighbours() const { return m_neighbours; }
+    // Size of the weight table, for memory budgets
+    size_t tableBytes() const { return m_station.size() * sizeof(int) + m_weight.size() * sizeof(float); }
+
+    // Flags the stations that are a neighbour of at least one cell (in nearest mode, every station
+    // the widened search could fall back to)
+    std::vector<bool> usedStations(size_t stationCount) const;
+
+private:
+    class KdTree;
+
+    InterpolationMode m_mode;
+    size_t m_cells = 0;
+    size_t m_neighbours = 0;
+    std::vector<int> m_station;   // cells * m_neighbours station indices
+    std::vector<float> m_weight;  // matching inverse-distance weights
+
+    // Nearest mode keeps the tree to widen the search past the k neighbours
+    std::shared_ptr<const KdTree> m_tree;
+    double m_minLat = 0, m_minLon = 0, m_resolution = 0, m_lonScale = 1;
+    int m_nLon = 0;
+};
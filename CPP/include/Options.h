@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Variables.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Settings accepted by the Converter API, with parsers for their command-line forms.
+// The modules that implement them (Interpolator, QualityControl, ...) stay internal.
+
+enum class InterpolationMode { None, Nearest, Idw };
+
+bool parseInterpolationMode(const std::string& text, InterpolationMode& mode);
+std::string interpolationModeName(InterpolationMode mode);
+
+// What to do with values outside a variable's physical range (and tmin > tmax days)
+enum class RangeAction { Flag, Clip, Mask };
+
+bool parseRangeAction(const std::string& text, RangeAction& action);
+std::string rangeActionName(RangeAction action);
+
+struct QualityOptions {
+    std::vector<double> sentinels = {-99.0, -999.0}; // input values meaning "no data"
+    RangeAction action = RangeAction::Flag;
+};
+
+struct VariableQaStats {
+    VariableId id = VariableId::Pcp;
+    std::string name;
+    size_t values = 0;        // total values inspected
+    size_t sentinels = 0;     // input sentinels mapped to the output fill value
+    size_t missing = 0;       // fill values after normalization
+    size_t belowRange = 0;
+    size_t aboveRange = 0;
+    size_t inconsistent = 0;  // tmin > tmax (reported on both temperature variables)
+    double min = 0;           // over valid values, after the range action
+    double max = 0;
+};
+
+enum class PetMethod { Hargreaves, PriestleyTaylor };
+
+bool parsePetMethod(const std::string& text, PetMethod& method);
+std::string petMethodName(PetMethod method);
+
+// How station files are read: batched through io_uring (Linux) or posix_fadvise-hinted reads
+enum class IoBackend { Auto, Uring, Posix };
+
+bool parseIoBackend(const std::string& text, IoBackend& backend);
+
+// How the time axis is split into separate output files
+struct ShardSpec {
+    enum Mode { None, Year, Decade, Days } mode = None;
+    int days = 0; // shard length for Mode::Days
+};
+
+// parses "year", "decade" or a positive number of days
+bool parseShardSpec(const std::string& text, ShardSpec& spec);
+
+// Spatial split of the output grid into rows x cols tiles, converted by
+// separate processes and merged back into one file.
+struct TileSpec {
+    int rows = 1;
+    int cols = 1;
+    int index = -1; // 0-based tile this process converts; -1 = all tiles
+
+    int count() const { return rows * cols; }
+    bool enabled() const { return count() > 1; }
+};
+
+// parses "RxC", e.g. "4x8"
+bool parseTileLayout(const std::string& text, TileSpec& spec);
+// parses "i/N" with 1 <= i <= N; keeps a matching RxC layout, otherwise picks the squarest one for N
+bool parseTileIndex(const std::string& text, TileSpec& spec);
+
+// parses a byte count with an optional K, M or G suffix (powers of 1024), e.g. "512M"
+bool parseMemorySize(const std::string& text, size_t& bytes);
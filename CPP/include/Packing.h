@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Variables.h"
+#include <cstdint>
+
+struct VariableData;
+
+// CF packing of a float variable into int16: value = packed * scale + offset
+struct PackParams {
+    double scale = 1.0;
+    double offset = 0.0;
+};
+
+namespace Packing {
+    const int16_t kFillValue = -32768;  // _FillValue; data uses [-32767, 32767]
+
+    // Storage precision a variable is packed at when its range allows (0 = use the data range)
+    double precision(VariableId id);
+
+    // Min/max pass over all station series (ignoring fill) and the resulting scale/offset
+    PackParams compute(const VariableData& vd, double fill);
+
+    // Scale/offset for values in [min, max]
+    PackParams fromBounds(VariableId id, double min, double max);
+
+    // Fixed-precision parameters spanning the variable's QA valid range, independent of the data
+    // (used when tiles must agree without seeing each other's stations). Values outside the range clip.
+    // False when the variable has no precision, or its range does not fit int16 at that precision.
+    bool fromRange(VariableId id, PackParams& params);
+
+    void pack(const float* in, size_t n, const PackParams& params, float fill, int16_t* out);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Options.h"
+#include <string>
+#include <vector>
+
+struct VariableData;
+
+struct ValidRange {
+    double min;
+    double max;
+};
+
+// Physical range of a variable from the variable registry
+ValidRange validRange(VariableId id);
+
+namespace QualityControl {
+    // Normalizes sentinels and applies range checks in place over every station series.
+    std::vector<VariableQaStats> run(std::vector<VariableData>& weatherData, const QualityOptions& options);
+    // Adds the counts of `part` (the same variable over other stations) into `total`
+    void merge(VariableQaStats& total, const VariableQaStats& part);
+    bool writeReport(const std::string& path, const std::vector<VariableQaStats>& stats, const QualityOptions& options);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class Converter;
+
+// One re-gridding request answered from stations already in memory (--serve).
+struct ServeRequest {
+    std::string output;                 // .nc4 path relative to the output directory, which it may not leave
+    double resolution = 0.25;
+    std::string shapePath;              // grid extent from this shapefile
+    std::vector<double> bounds;         // {minLat, maxLat, minLon, maxLon}; default: station extent plus one cell
+    std::string start, end;             // YYYY-MM-DD window; empty = start/end of the record
+    std::vector<std::string> variables; // weather groups; empty = every loaded group
+    size_t threads = 0;                 // gridding threads, set by the server from its pool size; 0 = one per core
+};
+
+struct ServeReply {
+    std::string output;
+    int nLat = 0, nLon = 0;
+    size_t nTime = 0;
+    std::string error; // empty on success
+};
+
+// parses one request line, e.g. {"output": "run7.nc4", "resolution": 0.1, "variables": ["pcp"]}
+bool parseServeRequest(const std::string& json, ServeRequest& request, std::string& error);
+
+namespace Server {
+    // Listens on a Unix socket and answers newline-delimited JSON requests with
+    // one JSON line each, `workers` connections at a time. {"command": "status"}
+    // describes the loaded stations and {"command": "stop"} shuts the server down.
+    // Returns false if the socket cannot be opened.
+    bool run(const Converter& converter, const std::string& socketPath, size_t workers);
+}
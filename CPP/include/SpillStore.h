@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Options.h"
+#include "Variables.h"
+#include <array>
+#include <string>
+#include <vector>
+
+struct Station;
+
+// External-memory transpose of station series for one conversion.
+//
+// Station files arrive station-major while the output is written time-major.
+// The store is a memory-mapped scratch file holding, per variable, a
+// (time blocks) x (station blocks) array of tiles; each tile is timeBlock x
+// stationBlock floats, time-major. Loading writes the series of a block of
+// stations into one column of tiles; gridding reads a time range back as a
+// row of tiles, so both passes touch a bounded, mostly contiguous window and
+// the kernel writes dirty pages back to the file instead of to swap.
+class SpillStore {
+public:
+    // origin is the day index of time step 0 (Utils::dayIndex of the grid start)
+    SpillStore(const std::string& path, long origin, int stepsPerDay, size_t nTime, size_t stationBlock, size_t timeBlock);
+    ~SpillStore();
+
+    SpillStore(const SpillStore&) = delete;
+    SpillStore& operator=(const SpillStore&) = delete;
+
+    // Reserves room for `slots` stations of a variable; false if the scratch file cannot grow
+    bool addVariable(VariableId id, size_t slots);
+    bool has(VariableId id) const { return m_vars[static_cast<size_t>(id)].data != nullptr; }
+    // Forgets a variable; its space in the scratch file is not reused
+    void remove(VariableId id);
+    size_t slots(VariableId id) const { return m_vars[static_cast<size_t>(id)].slots; }
+    size_t stationBlock() const { return m_stationBlock; }
+
+    // Stores stations[i] in slot firstSlot + i, shifted onto the common time axis.
+    // Every slot must be written (or filled) once before it is read.
+    void write(VariableId id, size_t firstSlot, const std::vector<Station>& stations, size_t first, size_t count);
+    // Marks slots [fromSlot, slots) as missing
+    void fill(VariableId id, size_t fromSlot);
+
+    // out[t * slots(id) + s] = value of slot s at time timeStart + t
+    void read(VariableId id, size_t timeStart, size_t timeCount, float* out) const;
+    // Whole series of one slot on the common time axis
+    std::vector<double> series(VariableId id, size_t slot) const;
+
+    // Smallest and largest stored value (false if the variable holds no data)
+    bool bounds(VariableId id, double& min, double& max) const;
+
+    const std::string& path() const { return m_path; }
+
+private:
+    struct Region {
+        size_t slots = 0;
+        size_t stationBlocks = 0;
+        size_t offset = 0;   // byte offset in the scratch file
+        size_t bytes = 0;
+        float* data = nullptr; // null while the variable is not in the store
+        double min, max;
+    };
+
+    std::string m_path;
+    long m_origin;
+    int m_stepsPerDay;
+    size_t m_nTime;
+    size_t m_stationBlock;
+    size_t m_timeBlock;
+    size_t m_timeBlocks;
+    size_t m_fileSize = 0;
+    int m_fd = -1;
+    std::array<Region, Variables::kVariableCount> m_vars;
+    std::vector<std::vector<float>> m_heap; // regions when memory mapping is unavailable
+
+    float* tile(const Region& region, size_t timeBlock, size_t stationBlock) const;
+};
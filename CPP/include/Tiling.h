@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Options.h"
+#include <string>
+#include <vector>
+
+struct GridSpec;
+
+// Tiles are converted by separate processes and merged back into one file (layout: TileSpec).
+
+// Cell range of one tile on the full grid. Tile edges fall on chunk
+// boundaries so the merge writes whole chunks.
+struct Tile {
+    int index;
+    int latStart, latCount;
+    int lonStart, lonCount;
+    int chunkLat, chunkLon;
+};
+
+// Row-major tiles covering the grid; empty if the grid has fewer rows/columns than the layout
+std::vector<Tile> gridTiles(const GridSpec& grid, const TileSpec& spec);
+
+// The tile as a grid of its own (same resolution and time axis)
+GridSpec tileGrid(const GridSpec& grid, const Tile& tile);
+
+// Chunk shape {time, lat, lon} of tile files and of the merged file (about 4 MB per chunk)
+std::vector<size_t> tileChunking(const Tile& tile, size_t nTime);
+
+// <region>_tile<i>of<N>.nc4 (1-based i)
+std::string tileFileName(const std::string& region, int index, int count);
+
+namespace Tiling {
+    // Re-runs this executable once per tile with `--tile i/N` appended to args,
+    // at most `jobs` at a time; each child's stdout goes to <logPrefix><i>of<N>.log.
+    // Returns false if any child fails.
+    bool runProcesses(const std::vector<std::string>& args, int count, size_t jobs, const std::string& logPrefix);
+
+    // Assembles tile files into one grid with chunk-aligned hyperslab copies of
+    // the stored (possibly packed) values. Returns the merged variable names
+    // and units, or an empty list on failure.
+    std::vector<std::pair<std::string, std::string>> merge(const std::vector<std::string>& tileFiles, const std::string& output);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Options.h"
+#include <string>
+#include <vector>
+
+struct GridSpec;
+
+struct TimeShard {
+    std::string label;   // e.g. "1983", "1980s", "1983-01-01_1983-04-10"
+    size_t timeStart;
+    size_t timeCount;
+};
+
+// Consecutive, non-overlapping shards covering the grid's whole time axis
+std::vector<TimeShard> timeShards(const GridSpec& grid, const ShardSpec& spec);
+
+// NcML joinExisting aggregation listing the shard files in time order
+bool writeShardIndex(const std::string& path, const std::vector<TimeShard>& shards, const std::vector<std::string>& files);
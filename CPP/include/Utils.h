@@ -10,6 +10,25 @@ namespace Utils {
     std::vector<std::string> listFiles(const std::string& path);
     std::string readFile(const std::string& path);
     bool writeFile(const std::string& path, const std::string& content);
-    void updateFileCIO(const std::string& txtInOutDir, const std::string& convertedDir, const std::string& regionName);
+    // Creates an empty file with a unique name next to `path` (path.XXXXXX) to write before renaming it
+    // over `path`, so concurrent writers of the same output never share a temporary; empty on failure
+    std::string temporaryFile(const std::string& path);
+    // Files of a TxtInOut folder copied next to the NetCDF output (not station files or weather-sta.cli)
+    bool isModelInputFile(const std::string& filename);
+    // Points the selected weather groups (all when `variables` is empty) at <region>.nc4 and the others at null
+    void updateFileCIO(const std::string& txtInOutDir, const std::string& convertedDir, const std::string& regionName,
+                       const std::vector<std::string>& variables = {});
+    // Same, from the contents of the original file.cio (e.g. read from an archive)
+    void writeFileCIO(const std::string& content, const std::string& convertedDir, const std::string& regionName,
+                      const std::vector<std::string>& variables = {});
+    // Weather groups (pcp, tmp, slr, hmd, wnd, pet) with a non-null entry on the file.cio climate line;
+    // empty if the line is missing or already points at netcdf.ncw
+    std::vector<std::string> climateVariables(const std::string& txtInOutDir);
+    std::vector<std::string> parseClimateVariables(const std::string& content);
+    // parses a comma-separated list of weather groups, e.g. "pcp,tmp"
+    bool parseVariableList(const std::string& text, std::vector<std::string>& groups);
+    long dayIndex(int year, int dayOfYear); // days since 1970-01-01
+    std::string formatDate(long dayIndex);  // YYYY-MM-DD
+    bool parseDate(const std::string& text, long& dayIndex); // YYYY-MM-DD
     void dualProgress(int primaryCount, int primaryEnd, int secondaryCount, int secondaryEnd, int barLength = 40, const std::string& message = "");
 }
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Kinds of station files, in loading order (solar radiation and humidity come
+// before temperature so that PET derivation finds them when spilling)
+enum class WeatherGroup { Pcp, Hmd, Slr, Wnd, Tmp, Pet };
+
+// Output variables, in the order they are written
+enum class VariableId { Pcp, Hmd, Slr, Wnd, Tmax, Tmin, Pet };
+
+struct GroupDescriptor {
+    WeatherGroup id;
+    const char* name;               // --variables, file.cio and netcdf.ncw key
+    const char* extension;          // station file extension
+    const char* preferredExtension; // read instead of `extension` when any such file exists (nullptr = none)
+    int columns;                    // value columns after the date columns of each row
+    int climateColumn;              // entry on the file.cio climate line after weather-sta.cli and weather-wgn.cli
+};
+
+struct VariableDescriptor {
+    VariableId id;
+    WeatherGroup group;
+    const char* name;          // NetCDF variable and netcdf.ncw column
+    const char* unit;
+    int column;                // value column within the rows of its group
+    double validMin, validMax; // physical range checked by --qa
+    double precision;          // --pack step when the data range allows it
+    float fill;
+    int ncwColumn;             // netcdf.ncw column after elevation
+    bool ncwIfLoaded;          // marked in netcdf.ncw only when loaded or derived, not merely selected
+};
+
+// Registry of weather groups and variables. Adding a variable (e.g. dew point)
+// takes one group and one variable entry; everything else reads these tables.
+namespace Variables {
+    constexpr float kFillValue = -9999.0f;
+
+    // inline: one table for the whole program, so lookups in any file return the same descriptors
+    inline constexpr GroupDescriptor kGroups[] = {
+        {WeatherGroup::Pcp, "pcp", ".pcp", nullptr, 1, 1},
+        {WeatherGroup::Hmd, "hmd", ".hmd", nullptr, 1, 4},
+        {WeatherGroup::Slr, "slr", ".slr", nullptr, 1, 3},
+        {WeatherGroup::Wnd, "wnd", ".wnd", nullptr, 1, 5},
+        {WeatherGroup::Tmp, "tmp", ".tmp", ".tem", 2, 2},
+        {WeatherGroup::Pet, "pet", ".pet", nullptr, 1, 0},
+    };
+
+    inline constexpr VariableDescriptor kVariables[] = {
+        {VariableId::Pcp,  WeatherGroup::Pcp, "pcp",  "mm",       0,   0.0, 2000.0, 0.1,    kFillValue, 0, false}, // mm/day
+        {VariableId::Hmd,  WeatherGroup::Hmd, "hmd",  "fraction", 0,   0.0,    1.0, 0.0001, kFillValue, 4, false},
+        {VariableId::Slr,  WeatherGroup::Slr, "slr",  "MJ/m2",    0,   0.0,   50.0, 0.01,   kFillValue, 3, false}, // MJ/m2/day
+        {VariableId::Wnd,  WeatherGroup::Wnd, "wnd",  "m/s",      0,   0.0,   75.0, 0.01,   kFillValue, 5, false},
+        {VariableId::Tmax, WeatherGroup::Tmp, "tmax", "degC",     0, -90.0,   60.0, 0.01,   kFillValue, 2, false},
+        {VariableId::Tmin, WeatherGroup::Tmp, "tmin", "degC",     1, -90.0,   60.0, 0.01,   kFillValue, 1, false},
+        {VariableId::Pet,  WeatherGroup::Pet, "pet",  "mm",       0,   0.0,   30.0, 0.01,   kFillValue, 6, true},  // mm/day
+    };
+
+    constexpr size_t kGroupCount = sizeof(kGroups) / sizeof(kGroups[0]);
+    constexpr size_t kVariableCount = sizeof(kVariables) / sizeof(kVariables[0]);
+
+    constexpr const GroupDescriptor& group(WeatherGroup id) { return kGroups[static_cast<size_t>(id)]; }
+    constexpr const VariableDescriptor& variable(VariableId id) { return kVariables[static_cast<size_t>(id)]; }
+
+    // Widest row of any group; the station parser is instantiated for 1..kMaxColumns value columns
+    constexpr int maxColumns() {
+        int widest = 1;
+        for (const auto& g : kGroups) widest = g.columns > widest ? g.columns : widest;
+        return widest;
+    }
+    constexpr size_t kMaxColumns = static_cast<size_t>(maxColumns());
+
+    // Both tables are indexed by their enum, every variable reads its own column of its group's
+    // rows, the file.cio and netcdf.ncw positions are each used once, and the gridding code
+    // fills every variable with the same value
+    constexpr bool consistent() {
+        for (size_t i = 0; i < kGroupCount; ++i) {
+            const GroupDescriptor& g = kGroups[i];
+            if (static_cast<size_t>(g.id) != i || g.columns < 1) return false;
+            if (g.climateColumn < 0 || static_cast<size_t>(g.climateColumn) >= kGroupCount) return false;
+            for (size_t j = 0; j < i; ++j) if (kGroups[j].climateColumn == g.climateColumn) return false;
+        }
+        for (size_t i = 0; i < kVariableCount; ++i) {
+            const VariableDescriptor& v = kVariables[i];
+            if (static_cast<size_t>(v.id) != i || v.column >= group(v.group).columns || v.fill != kFillValue) return false;
+            if (v.ncwColumn < 0 || static_cast<size_t>(v.ncwColumn) >= kVariableCount) return false;
+            for (size_t j = 0; j < i; ++j) {
+                if (kVariables[j].ncwColumn == v.ncwColumn) return false;
+                if (kVariables[j].group == v.group && kVariables[j].column == v.column) return false;
+            }
+        }
+        return true;
+    }
+    static_assert(consistent(), "weather group and variable tables are out of order or inconsistent");
+
+    // Lookups by name for command-line, request and file metadata strings; nullptr if unknown
+    const GroupDescriptor* findGroup(const std::string& name);
+    const VariableDescriptor* findVariable(const std::string& name);
+}
@@ -0,0 +1,343 @@
+#include "Archive.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <zlib.h>
+
+namespace {
+
+using EntryCallback = std::function<void(const std::string&, std::string&)>;
+
+const size_t kInputChunk = 1 << 20; // compressed bytes read per refill
+const size_t kTarBlock = 512;
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t le32(const unsigned char* p) { return static_cast<uint32_t>(le16(p)) | (static_cast<uint32_t>(le16(p + 2)) << 16); }
+uint64_t le64(const unsigned char* p) { return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32); }
+
+// Sequential bytes of a plain or gzip-compressed file (concatenated gzip members included)
+class Stream {
+public:
+    ~Stream() { if (m_gzip) inflateEnd(&m_zs); }
+
+    bool open(const std::string& path, bool gzip) {
+        m_file.open(path, std::ios::binary);
+        if (!m_file.is_open()) return false;
+        if (gzip) {
+            std::memset(&m_zs, 0, sizeof(m_zs));
+            if (inflateInit2(&m_zs, 16 + MAX_WBITS) != Z_OK) return false;
+            m_gzip = true;
+            m_input.resize(kInputChunk);
+        }
+        return true;
+    }
+
+    // Fills out[0, n); false at the end of the data or on a corrupt stream
+    bool read(char* out, size_t n) {
+        if (!m_gzip) {
+            m_file.read(out, static_cast<std::streamsize>(n));
+            return static_cast<size_t>(m_file.gcount()) == n;
+        }
+        m_zs.next_out = reinterpret_cast<Bytef*>(out);
+        m_zs.avail_out = static_cast<uInt>(n);
+        while (m_zs.avail_out > 0) {
+            if (m_zs.avail_in == 0) {
+                m_file.read(reinterpret_cast<char*>(m_input.data()), static_cast<std::streamsize>(m_input.size()));
+                m_zs.next_in = m_input.data();
+                m_zs.avail_in = static_cast<uInt>(m_file.gcount());
+                if (m_zs.avail_in == 0) return false;
+            }
+            int status = inflate(&m_zs, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                if (inflateReset(&m_zs) != Z_OK) return false;
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                m_corrupt = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool skip(size_t n) {
+        char buffer[64 * 1024];
+        while (n > 0) {
+            size_t step = std::min(n, sizeof(buffer));
+            if (!read(buffer, step)) return false;
+            n -= step;
+        }
+        return true;
+    }
+
+    bool corrupt() const { return m_corrupt; }
+
+private:
+    std::ifstream m_file;
+    bool m_gzip = false;
+    bool m_corrupt = false;
+    z_stream m_zs;
+    std::vector<unsigned char> m_input;
+};
+
+// Size field of a tar header: octal text, or base-256 when the high bit is set (GNU, > 8 GB)
+uint64_t tarNumber(const unsigned char* field, size_t length) {
+    uint64_t value = 0;
+    if (field[0] & 0x80) {
+        for (size_t i = 1; i < length; ++i) value = (value << 8) | field[i];
+        return value;
+    }
+    for (size_t i = 0; i < length && field[i] != '\0'; ++i) {
+        if (field[i] >= '0' && field[i] <= '7') value = value * 8 + (field[i] - '0');
+    }
+    return value;
+}
+
+std::string tarString(const unsigned char* field, size_t length) {
+    const char* text = reinterpret_cast<const char*>(field);
+    return std::string(text, strnlen(text, length));
+}
+
+bool tarChecksumValid(const unsigned char* header) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < kTarBlock; ++i) sum += (i >= 148 && i < 156) ? ' ' : header[i];
+    return sum == tarNumber(header + 148, 8);
+}
+
+// "path" record of a pax extended header ("<length> path=<value>\n" records)
+std::string paxPath(const std::string& records) {
+    size_t pos = 0;
+    while (pos < records.size()) {
+        size_t space = records.find(' ', pos);
+        if (space == std::string::npos) break;
+        size_t length = std::strtoul(records.c_str() + pos, nullptr, 10);
+        if (length == 0 || pos + length > records.size()) break;
+        std::string record = records.substr(space + 1, pos + length - space - 2);
+        if (record.compare(0, 5, "path=") == 0) return record.substr(5);
+        pos += length;
+    }
+    return "";
+}
+
+bool readTar(const std::string& path, bool gzip, const EntryCallback& onEntry) {
+    Stream stream;
+    if (!stream.open(path, gzip)) {
+        std::cerr << "Error: Could not open archive " << path << std::endl;
+        return false;
+    }
+
+    unsigned char header[kTarBlock];
+    std::string longName; // from a GNU 'L' or pax 'x' entry, applies to the next entry
+    while (true) {
+        if (!stream.read(reinterpret_cast<char*>(header), kTarBlock)) break;
+        if (std::all_of(header, header + kTarBlock, [](unsigned char c) { return c == 0; })) return true;
+        if (!tarChecksumValid(header)) {
+            std::cerr << "Error: " << path << " is not a tar archive or is corrupt." << std::endl;
+            return false;
+        }
+
+        uint64_t size = tarNumber(header + 124, 12);
+        size_t padding = static_cast<size_t>((kTarBlock - size % kTarBlock) % kTarBlock);
+        char type = static_cast<char>(header[156]);
+
+        std::string name = tarString(header, 100);
+        if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0') {
+            name = tarString(header + 345, 155) + "/" + name;
+        }
+        if (!longName.empty()) {
+            name = longName;
+            longName.clear();
+        }
+
+        if (type == '0' || type == '\0' || type == 'L' || type == 'x') {
+            std::string content(static_cast<size_t>(size), '\0');
+            if (!stream.read(&content[0], content.size()) || !stream.skip(padding)) break;
+            if (type == 'L') longName = tarString(reinterpret_cast<const unsigned char*>(content.data()), content.size());
+            else if (type == 'x') longName = paxPath(content);
+            else onEntry(name, content);
+        } else if (!stream.skip(static_cast<size_t>(size) + padding)) {
+            break; // directories, links and global headers carry no file data
+        }
+    }
+
+    // A tar stream ends with zero blocks; running out of data before them means truncation
+    std::cerr << "Error: " << path << (stream.corrupt() ? " is corrupt." : " is truncated.") << std::endl;
+    return false;
+}
+
+struct ZipEntry {
+    std::string name;
+    uint16_t flags = 0, method = 0;
+    uint32_t crc = 0;
+    uint64_t compressedSize = 0, size = 0, offset = 0;
+};
+
+// Central directory location from the end records (zip64 when the classic fields overflow)
+bool zipDirectory(std::ifstream& file, uint64_t& entries, uint64_t& offset) {
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    size_t tail = static_cast<size_t>(std::min<uint64_t>(fileSize, 22 + 65535));
+    std::vector<unsigned char> buffer(tail);
+    file.seekg(static_cast<std::streamoff>(fileSize - tail));
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(tail));
+    if (!file || tail < 22) return false;
+
+    for (size_t i = tail - 22 + 1; i-- > 0;) {
+        const unsigned char* end = buffer.data() + i;
+        if (le32(end) != 0x06054b50) continue;
+        entries = le16(end + 10);
+        offset = le32(end + 16);
+        if (offset != 0xFFFFFFFF && entries != 0xFFFF) return true;
+
+        // Zip64 end of central directory locator, immediately before the classic record
+        if (i < 20 || le32(end - 20) != 0x07064b50) return false;
+        unsigned char record[56];
+        file.seekg(static_cast<std::streamoff>(le64(end - 20 + 8)));
+        file.read(reinterpret_cast<char*>(record), sizeof(record));
+        if (!file || le32(record) != 0x06064b50) return false;
+        entries = le64(record + 32);
+        offset = le64(record + 48);
+        return true;
+    }
+    return false;
+}
+
+bool readZip(const std::string& path, const EntryCallback& onEntry) {
+    std::ifstream file(path, std::ios::binary);
+    uint64_t count = 0, directory = 0;
+    if (!file.is_open() || !zipDirectory(file, count, directory)) {
+        std::cerr << "Error: " << path << " is not a zip archive or is corrupt." << std::endl;
+        return false;
+    }
+
+    std::vector<ZipEntry> entries;
+    entries.reserve(static_cast<size_t>(count));
+    file.seekg(static_cast<std::streamoff>(directory));
+    for (uint64_t e = 0; e < count; ++e) {
+        unsigned char fixed[46];
+        file.read(reinterpret_cast<char*>(fixed), sizeof(fixed));
+        if (!file || le32(fixed) != 0x02014b50) {
+            std::cerr << "Error: Corrupt central directory in " << path << std::endl;
+            return false;
+        }
+        ZipEntry entry;
+        entry.flags = le16(fixed + 8);
+        entry.method = le16(fixed + 10);
+        entry.crc = le32(fixed + 16);
+        entry.compressedSize = le32(fixed + 20);
+        entry.size = le32(fixed + 24);
+        entry.offset = le32(fixed + 42);
+        std::string variable(static_cast<size_t>(le16(fixed + 28)) + le16(fixed + 30) + le16(fixed + 32), '\0');
+        file.read(&variable[0], static_cast<std::streamsize>(variable.size()));
+        entry.name = variable.substr(0, le16(fixed + 28));
+
+        // Zip64 extra field: 64-bit values for whichever fields are saturated, in this order
+        const unsigned char* extra = reinterpret_cast<const unsigned char*>(variable.data()) + le16(fixed + 28);
+        const unsigned char* extraEnd = extra + le16(fixed + 30);
+        while (extra + 4 <= extraEnd) {
+            uint16_t id = le16(extra), length = le16(extra + 2);
+            const unsigned char* value = extra + 4;
+            if (id == 0x0001) {
+                for (uint64_t* field : {&entry.size, &entry.compressedSize, &entry.offset}) {
+                    if (*field != 0xFFFFFFFF || value + 8 > extra + 4 + length) continue;
+                    *field = le64(value);
+                    value += 8;
+                }
+            }
+            extra += 4 + length;
+        }
+        if (!entry.name.empty() && entry.name.back() != '/') entries.push_back(std::move(entry));
+    }
+
+    // Stored order, so the file is read front to back once
+    std::sort(entries.begin(), entries.end(), [](const ZipEntry& a, const ZipEntry& b) { return a.offset < b.offset; });
+
+    std::vector<unsigned char> input(kInputChunk);
+    for (const auto& entry : entries) {
+        if (entry.flags & 0x1) {
+            std::cerr << "Warning: Skipping encrypted entry " << entry.name << std::endl;
+            continue;
+        }
+        if (entry.method != 0 && entry.method != 8) {
+            std::cerr << "Warning: Skipping " << entry.name << " (unsupported compression method " << entry.method << ")" << std::endl;
+            continue;
+        }
+
+        unsigned char local[30];
+        file.seekg(static_cast<std::streamoff>(entry.offset));
+        file.read(reinterpret_cast<char*>(local), sizeof(local));
+        if (!file || le32(local) != 0x04034b50) {
+            std::cerr << "Error: Corrupt entry " << entry.name << " in " << path << std::endl;
+            return false;
+        }
+        file.seekg(le16(local + 26) + le16(local + 28), std::ios::cur);
+
+        std::string content(static_cast<size_t>(entry.size), '\0');
+        bool ok = true;
+        if (entry.method == 0) {
+            file.read(&content[0], static_cast<std::streamsize>(content.size()));
+            ok = static_cast<size_t>(file.gcount()) == content.size() && entry.compressedSize == entry.size;
+        } else {
+            z_stream zs;
+            std::memset(&zs, 0, sizeof(zs));
+            ok = inflateInit2(&zs, -MAX_WBITS) == Z_OK;
+            zs.next_out = reinterpret_cast<Bytef*>(&content[0]);
+            zs.avail_out = static_cast<uInt>(content.size());
+            uint64_t remaining = entry.compressedSize;
+            int status = Z_OK;
+            while (ok && status != Z_STREAM_END) {
+                if (zs.avail_in == 0) {
+                    size_t step = static_cast<size_t>(std::min<uint64_t>(remaining, input.size()));
+                    file.read(reinterpret_cast<char*>(input.data()), static_cast<std::streamsize>(step));
+                    if (step == 0 || static_cast<size_t>(file.gcount()) != step) { ok = false; break; }
+                    remaining -= step;
+                    zs.next_in = input.data();
+                    zs.avail_in = static_cast<uInt>(step);
+                }
+                status = inflate(&zs, Z_NO_FLUSH);
+                ok = status == Z_OK || status == Z_STREAM_END;
+            }
+            ok = ok && zs.avail_out == 0;
+            inflateEnd(&zs);
+        }
+
+        uLong crc = crc32(0L, Z_NULL, 0);
+        if (ok) crc = crc32(crc, reinterpret_cast<const Bytef*>(content.data()), static_cast<uInt>(content.size()));
+        if (!ok || crc != entry.crc) {
+            std::cerr << "Error: Corrupt entry " << entry.name << " in " << path << std::endl;
+            return false;
+        }
+        onEntry(entry.name, content);
+    }
+    return true;
+}
+
+}
+
+namespace Archive {
+
+    bool isArchive(const std::string& path) {
+        std::string name = lowercase(path);
+        bool named = endsWith(name, ".zip") || endsWith(name, ".tar") || endsWith(name, ".tar.gz") || endsWith(name, ".tgz");
+        std::error_code ec;
+        return named && std::filesystem::is_regular_file(path, ec);
+    }
+
+    bool read(const std::string& path, const std::function<void(const std::string&, std::string&)>& onEntry) {
+        std::string name = lowercase(path);
+        if (endsWith(name, ".zip")) return readZip(path, onEntry);
+        return readTar(path, endsWith(name, ".gz") || endsWith(name, ".tgz"), onEntry);
+    }
+}
@@ -0,0 +1,383 @@
+#include "BatchReader.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SWAT2NETCDF_POSIX_IO 1
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef SWAT2NETCDF_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+bool parseIoBackend(const std::string& text, IoBackend& backend) {
+    if (text == "auto") backend = IoBackend::Auto;
+    else if (text == "uring") backend = IoBackend::Uring;
+    else if (text == "posix") backend = IoBackend::Posix;
+    else return false;
+    return true;
+}
+
+namespace {
+
+using FileCallback = std::function<void(size_t, std::string&)>;
+
+#ifdef SWAT2NETCDF_POSIX_IO
+
+// Returns the descriptor, or -errno on failure (matching io_uring completion results)
+int openSync(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return fd >= 0 ? fd : -errno;
+}
+
+// Reads buffer[offset, size) with pread; used for short reads and as the synchronous fallback
+bool readRemaining(int fd, std::string& buffer, size_t offset) {
+    while (offset < buffer.size()) {
+        ssize_t n = pread(fd, &buffer[offset], buffer.size() - offset, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) {
+            buffer.resize(offset); // file shrank since fstat
+            break;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool allocateForFile(int fd, std::string& buffer) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    buffer.assign(static_cast<size_t>(st.st_size), '\0');
+    return true;
+}
+
+void readBatchPosix(const std::vector<std::string>& paths, size_t first, size_t last, const FileCallback& onFile) {
+    // Open the whole batch and hint every file before the first read, so the
+    // kernel (or NFS client) can fetch them concurrently.
+    std::vector<int> fds(last - first, -1);
+    for (size_t i = first; i < last; ++i) {
+        int fd = openSync(paths[i]);
+        fds[i - first] = fd;
+#ifdef POSIX_FADV_WILLNEED
+        if (fd >= 0) posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    }
+
+    std::string buffer;
+    for (size_t i = first; i < last; ++i) {
+        int fd = fds[i - first];
+        if (fd < 0) {
+            std::cerr << "Could not open " << paths[i] << ": " << std::strerror(-fd) << std::endl;
+            continue;
+        }
+        bool ok = allocateForFile(fd, buffer) && readRemaining(fd, buffer, 0);
+        close(fd);
+        if (!ok) {
+            std::cerr << "Could not read " << paths[i] << std::endl;
+            continue;
+        }
+        onFile(i, buffer);
+    }
+}
+
+#else
+
+void readBatchPosix(const std::vector<std::string>& paths, size_t first, size_t last, const FileCallback& onFile) {
+    for (size_t i = first; i < last; ++i) {
+        std::ifstream file(paths[i], std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Could not open " << paths[i] << std::endl;
+            continue;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        std::string buffer = ss.str();
+        onFile(i, buffer);
+    }
+}
+
+#endif
+
+#ifdef SWAT2NETCDF_HAVE_IO_URING
+
+// Minimal io_uring submission/completion ring on the raw system calls, so no
+// liburing dependency is needed. Single-threaded use only.
+class Uring {
+public:
+    ~Uring() {
+        if (m_sqes) munmap(m_sqes, m_sqesSize);
+        if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingSize);
+        if (m_sqRing) munmap(m_sqRing, m_sqRingSize);
+        if (m_fd >= 0) close(m_fd);
+    }
+
+    bool init(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0) return false;
+
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+        m_sqRing = map(m_sqRingSize, IORING_OFF_SQ_RING);
+        if (!m_sqRing) return false;
+        m_cqRing = singleMmap ? m_sqRing : map(m_cqRingSize, IORING_OFF_CQ_RING);
+        if (!m_cqRing) return false;
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(map(m_sqesSize, IORING_OFF_SQES));
+        if (!m_sqes) return false;
+
+        char* sq = static_cast<char*>(m_sqRing);
+        m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        m_sqEntries = params.sq_entries;
+
+        char* cq = static_cast<char*>(m_cqRing);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        m_localTail = *m_sqTail;
+        return true;
+    }
+
+    unsigned capacity() const { return m_sqEntries; }
+
+    io_uring_sqe* nextSqe() {
+        unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        if (m_localTail - head >= m_sqEntries) return nullptr;
+        unsigned index = m_localTail & m_sqMask;
+        m_sqArray[index] = index;
+        m_localTail++;
+        m_pending++;
+        io_uring_sqe* sqe = &m_sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Submits everything queued and calls onComplete(user_data, res) until `expected` completions arrived.
+    // If io_uring_enter fails, the entries the kernel has not taken are withdrawn and the ones it has
+    // are still waited for, so on a false return only withdrawn requests lack a completion. Should
+    // even that wait fail, requests stay in flight and idle() is false.
+    template <typename F>
+    bool submitAndCollect(unsigned expected, F&& onComplete) {
+        __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+        unsigned toSubmit = m_pending;
+        m_pending = 0;
+
+        bool ok = true;
+        unsigned collected = 0;
+        while (ok ? collected < expected : m_inFlight > 0) {
+            long ret = syscall(__NR_io_uring_enter, m_fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                if (!ok) return false;
+                ok = false;
+                m_localTail = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+                __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+                toSubmit = 0;
+                continue;
+            }
+            unsigned submitted = std::min<unsigned>(toSubmit, static_cast<unsigned>(ret));
+            toSubmit -= submitted;
+            m_inFlight += submitted;
+
+            unsigned head = *m_cqHead;
+            unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head, ++collected, --m_inFlight) {
+                const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                onComplete(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        }
+        return ok;
+    }
+
+    // No submitted request is waiting for its completion
+    bool idle() const { return m_inFlight == 0; }
+
+private:
+    int m_fd = -1;
+    void* m_sqRing = nullptr;
+    void* m_cqRing = nullptr;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqRingSize = 0, m_cqRingSize = 0, m_sqesSize = 0;
+
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0, m_sqEntries = 0;
+    unsigned m_localTail = 0, m_pending = 0, m_inFlight = 0;
+
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+
+    void* map(size_t size, off_t offset) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+};
+
+// Opcodes missing on older kernels complete with -EINVAL; those files are handled synchronously.
+bool unsupported(int res) {
+    return res == -EINVAL || res == -EOPNOTSUPP;
+}
+
+bool readBatchUring(Uring& ring, const std::vector<std::string>& paths, size_t first, size_t last, const FileCallback& onFile) {
+    const size_t n = last - first;
+    std::vector<int> fds(n, -1);
+    std::vector<std::string> buffers(n);
+
+    // 1. One submission for every open in the batch
+    for (size_t i = 0; i < n; ++i) {
+        io_uring_sqe* sqe = ring.nextSqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<unsigned long long>(paths[first + i].c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = i;
+    }
+    bool ok = ring.submitAndCollect(static_cast<unsigned>(n), [&](unsigned long long i, int res) {
+        fds[i] = unsupported(res) ? openSync(paths[first + i]) : res;
+    });
+    if (!ok) {
+        // Ring unusable: finish this batch synchronously and let the caller switch backends.
+        // Opens still in flight only reference the caller's paths, which outlive the ring.
+        for (int fd : fds) if (fd >= 0) close(fd);
+        readBatchPosix(paths, first, last, onFile);
+        return false;
+    }
+
+    // 2. One submission for every whole-file read
+    std::vector<char> pending(n, 0); // read queued, completion not seen yet
+    unsigned reads = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (fds[i] < 0 || !allocateForFile(fds[i], buffers[i]) || buffers[i].empty()) continue;
+        io_uring_sqe* sqe = ring.nextSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fds[i];
+        sqe->addr = reinterpret_cast<unsigned long long>(&buffers[i][0]);
+        sqe->len = static_cast<unsigned>(buffers[i].size());
+        sqe->off = 0;
+        sqe->user_data = i;
+        pending[i] = 1;
+        reads++;
+    }
+    std::vector<char> failed(n, 0);
+    ok = ring.submitAndCollect(reads, [&](unsigned long long i, int res) {
+        pending[i] = 0;
+        if (res >= 0) {
+            failed[i] = !readRemaining(fds[i], buffers[i], static_cast<size_t>(res)); // short read
+        } else {
+            failed[i] = !(unsupported(res) && readRemaining(fds[i], buffers[i], 0));
+        }
+    });
+    if (!ok && !ring.idle()) {
+        // The kernel may still write into these buffers: they must outlive the ring, so they are
+        // deliberately never freed, and the batch is read again into fresh memory
+        new std::vector<std::string>(std::move(buffers));
+        for (int fd : fds) if (fd >= 0) close(fd);
+        readBatchPosix(paths, first, last, onFile);
+        return false;
+    }
+    if (!ok) {
+        // Every completion the kernel owed has arrived; only the withdrawn reads remain
+        for (size_t i = 0; i < n; ++i) {
+            if (pending[i]) failed[i] = !readRemaining(fds[i], buffers[i], 0);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (fds[i] < 0) {
+            std::cerr << "Could not open " << paths[first + i] << ": " << std::strerror(-fds[i]) << std::endl;
+            continue;
+        }
+        close(fds[i]);
+        if (failed[i]) {
+            std::cerr << "Could not read " << paths[first + i] << std::endl;
+            continue;
+        }
+        onFile(first + i, buffers[i]);
+    }
+    return ok;
+}
+
+bool uringAvailable() {
+    static const bool available = [] {
+        Uring probe;
+        return probe.init(2);
+    }();
+    return available;
+}
+
+#endif
+
+}
+
+namespace BatchReader {
+
+    IoBackend resolve(IoBackend requested) {
+#ifdef SWAT2NETCDF_HAVE_IO_URING
+        if (requested != IoBackend::Posix && uringAvailable()) return IoBackend::Uring;
+#else
+        (void)requested;
+#endif
+        return IoBackend::Posix;
+    }
+
+    std::string backendName(IoBackend requested) {
+        return resolve(requested) == IoBackend::Uring ? "io_uring" : "posix";
+    }
+
+    void readFiles(const std::vector<std::string>& paths, const FileCallback& onFile, IoBackend backend, size_t batchSize) {
+        batchSize = std::max<size_t>(1, batchSize);
+
+        IoBackend resolved = resolve(backend);
+        if (backend == IoBackend::Uring && resolved != IoBackend::Uring) {
+            std::cerr << "Warning: io_uring is not available. Falling back to posix reads." << std::endl;
+        }
+
+#ifdef SWAT2NETCDF_HAVE_IO_URING
+        if (resolved == IoBackend::Uring) {
+            Uring ring;
+            if (ring.init(static_cast<unsigned>(batchSize))) {
+                batchSize = std::min<size_t>(batchSize, ring.capacity());
+                bool ringUsable = true;
+                for (size_t first = 0; first < paths.size(); first += batchSize) {
+                    size_t last = std::min(paths.size(), first + batchSize);
+                    if (ringUsable) {
+                        ringUsable = readBatchUring(ring, paths, first, last, onFile);
+                    } else {
+                        readBatchPosix(paths, first, last, onFile);
+                    }
+                }
+                return;
+            }
+        }
+#endif
+
+        for (size_t first = 0; first < paths.size(); first += batchSize) {
+            readBatchPosix(paths, first, std::min(paths.size(), first + batchSize), onFile);
+        }
+    }
+}
@@ -1,4 +1,13 @@
 #include "Converter.h"
+#include "WriteContext.h"
+#include "Archive.h"
+#include "BatchReader.h"
+#include "Evapotranspiration.h"
+#include "QualityControl.h"
+#include "Server.h"
+#include "SpillStore.h"
+#include "Tiling.h"
+#include "TimeShards.h"
 #include "Utils.h"
 #include <iostream>
 #include <fstream>
@@ -12,9 +21,55 @@
 #include <gdal_priv.h>
 #include <ogrsf_frmts.h>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 using namespace netCDF;
 
+// Upper bound on the gridded block buffered before each putVar call
+static const size_t kWriteBlockBytes = 64 * 1024 * 1024;
+
+// Serializes NetCDF library calls across shard writer threads
+static std::mutex s_netcdfMutex;
+
+// Releases a held lock for the lifetime of the scope, re-acquiring it on exit (also during unwinding)
+struct ScopedUnlock {
+    explicit ScopedUnlock(std::unique_lock<std::mutex>& lock) : m_lock(lock) { m_lock.unlock(); }
+    ~ScopedUnlock() { m_lock.lock(); }
+    std::unique_lock<std::mutex>& m_lock;
+};
+
+// One file has one time axis, so daily and sub-daily series cannot be written together
+static void reportMixedSteps(const std::string& first, int firstSteps, const std::string& other, int otherSteps) {
+    std::cerr << "Error: " << first << " has " << firstSteps << " time steps per day but " << other << " has "
+              << otherSteps << ". Convert them separately with --variables." << std::endl;
+}
+
+// lat, lon and elevation from the metadata (third) line of a station file
+static bool readCoordinates(std::istream& in, Station& station) {
+    std::string line;
+    for (int i = 0; i < 3; ++i) {
+        if (!std::getline(in, line)) return false;
+    }
+    std::stringstream ss(line);
+    std::vector<std::string> parts;
+    for (std::string temp; ss >> temp;) parts.push_back(temp);
+    if (parts.size() < 5) return false;
+    try {
+        station.lat = std::stod(parts[2]);
+        station.lon = std::stod(parts[3]);
+        station.elev = std::stod(parts[4]);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
 Converter::Converter(const std::string& region, const std::string& txtInOutDir, const std::string& convertedDir)
     : m_region(region), m_txtInOutDir(txtInOutDir), m_convertedDir(convertedDir) {
     
@@ -25,6 +80,8 @@ Converter::Converter(const std::string& region, const std::string& txtInOutDir,
     m_maxLon = std::numeric_limits<double>::lowest();
 }
 
+Converter::~Converter() = default;
+
 void Converter::run(double climateResolution, const std::string& shapePath, const std::string& stopDate) {
     m_resolution = climateResolution;
     std::cout << "Running conversion with resolution: " << m_resolution << std::endl;
@@ -33,38 +90,186 @@ void Converter::run(double climateResolution, const std::string& shapePath, cons
         readShapefile(shapePath);
     }
 
-    processWeatherFiles();
-    
-    // If bounds are still invalid (no shapefile and no stations?), set default or error
-    if (m_minLat > m_maxLat) {
-        std::cerr << "Warning: Could not determine bounds. Using default." << std::endl;
-        m_minLat = -90; m_maxLat = 90; m_minLon = -180; m_maxLon = 180;
-    } else if (shapePath.empty()) {
-        // Add buffer if no shapefile to avoid 1x1 grid on small extents
-        std::cout << "No shapefile provided. Adding buffer of " << m_resolution << " degrees." << std::endl;
-        m_minLat -= m_resolution;
-        m_maxLat += m_resolution;
-        m_minLon -= m_resolution;
-        m_maxLon += m_resolution;
-    }
+    // With a memory budget, series that do not fit are spilled to disk while loading (QA and PET included)
+    GridSpec grid;
+    if (m_maxMemory == 0 || !loadOutOfCore(!shapePath.empty(), grid)) {
+        if (!m_stationsLoaded) processWeatherFiles(); // archives are loaded up front, with their file.cio
 
-    std::cout << "Final Grid Bounds: " 
-              << "Lat [" << m_minLat << ", " << m_maxLat << "], "
-              << "Lon [" << m_minLon << ", " << m_maxLon << "]" << std::endl;
+        if (m_qualityEnabled) {
+            applyQualityControl();
+        }
+
+        if (m_derivePet) {
+            derivePet(m_petMethod);
+        }
+
+        grid = defineGrid(m_resolution, !shapePath.empty());
+    }
 
     // Check if we should create station list
-    std::string weatherStaPath = m_txtInOutDir + "/weather-sta.cli";
-    if (std::filesystem::exists(weatherStaPath)) {
+    std::string weatherSta;
+    if (readInputFile("weather-sta.cli", weatherSta)) {
         createStationListFile();
     } else {
         std::cout << "weather-sta.cli not found. Skipping netcdf.ncw creation." << std::endl;
     }
 
+    if (m_shardSpec.mode != ShardSpec::None) {
+        writeShards(grid, m_shardSpec, m_onlyShards);
+        return;
+    }
+
     std::string ncFilename = m_convertedDir + "/" + m_region + ".nc4";
-    createNetCDF(ncFilename);
+    createNetCDF(ncFilename, grid);
+}
+
+std::vector<VariableQaStats> Converter::applyQualityControl() {
+    std::cout << "Running QA (" << rangeActionName(m_qualityOptions.action) << " out-of-range values)..." << std::endl;
+    std::vector<VariableQaStats> stats = QualityControl::run(m_weatherData, m_qualityOptions);
+    reportQualityControl(stats);
+    return stats;
+}
+
+void Converter::reportQualityControl(const std::vector<VariableQaStats>& stats) const {
+    for (const auto& s : stats) {
+        std::cout << "  " << s.name << ": " << s.sentinels << " sentinels, "
+                  << (s.belowRange + s.aboveRange) << " out of range";
+        if (s.inconsistent > 0) std::cout << ", " << s.inconsistent << " days tmin > tmax";
+        std::cout << std::endl;
+    }
+
+    std::string reportPath = m_convertedDir + "/qa_report.txt";
+    if (m_tileSpec.enabled() && m_tileSpec.index >= 0) {
+        reportPath = m_convertedDir + "/qa_report_tile" + std::to_string(m_tileSpec.index + 1) + "of" + std::to_string(m_tileSpec.count()) + ".txt";
+    }
+    if (QualityControl::writeReport(reportPath, stats, m_qualityOptions)) {
+        std::cout << "QA report written to " << reportPath << std::endl;
+    } else {
+        std::cerr << "Warning: Could not write QA report " << reportPath << std::endl;
+    }
+}
+
+bool Converter::derivePet(PetMethod method) {
+    std::cout << "Deriving PET (" << petMethodName(method) << ") from loaded temperature..." << std::endl;
+
+    const VariableData* tmax = variableData(VariableId::Tmax);
+    if (tmax && std::any_of(tmax->stations.begin(), tmax->stations.end(), [](const Station& st) { return st.stepsPerDay > 1; })) {
+        std::cerr << "Warning: PET is derived from daily temperatures only; sub-daily temperature stations get no PET." << std::endl;
+    }
+
+    VariableData pet;
+    if (!Evapotranspiration::derive(m_weatherData, method, pet)) {
+        std::cerr << "Warning: tmax/tmin not loaded. Cannot derive PET." << std::endl;
+        return false;
+    }
+
+    VariableData* existing = variableData(VariableId::Pet);
+    if (existing) {
+        std::cout << "Replacing PET read from .pet files with derived values." << std::endl;
+        *existing = std::move(pet);
+    } else {
+        m_weatherData.push_back(std::move(pet));
+    }
+    return true;
+}
+
+const VariableData* Converter::findVariable(const std::string& varName) const {
+    const VariableDescriptor* descriptor = Variables::findVariable(varName);
+    return descriptor ? variableData(descriptor->id) : nullptr;
+}
+
+VariableData* Converter::variableData(VariableId id) {
+    for (auto& vd : m_weatherData) {
+        if (vd.id == id) return &vd;
+    }
+    return nullptr;
 }
 
-void Converter::createStationListFile() {
+const VariableData* Converter::variableData(VariableId id) const {
+    for (const auto& vd : m_weatherData) {
+        if (vd.id == id) return &vd;
+    }
+    return nullptr;
+}
+
+GridSpec Converter::defineGrid(double resolution, bool hasShapefile) const {
+    GridSpec grid;
+    grid.resolution = resolution;
+    grid.minLat = m_minLat; grid.maxLat = m_maxLat;
+    grid.minLon = m_minLon; grid.maxLon = m_maxLon;
+
+    // If bounds are still invalid (no shapefile and no stations?), set default or error
+    if (grid.minLat > grid.maxLat) {
+        std::cerr << "Warning: Could not determine bounds. Using default." << std::endl;
+        grid.minLat = -90; grid.maxLat = 90; grid.minLon = -180; grid.maxLon = 180;
+    } else if (!hasShapefile) {
+        // Add buffer if no shapefile to avoid 1x1 grid on small extents
+        std::cout << "No shapefile provided. Adding buffer of " << resolution << " degrees." << std::endl;
+        grid.minLat -= resolution;
+        grid.maxLat += resolution;
+        grid.minLon -= resolution;
+        grid.maxLon += resolution;
+    }
+
+    std::cout << "Final Grid Bounds: " 
+              << "Lat [" << grid.minLat << ", " << grid.maxLat << "], "
+              << "Lon [" << grid.minLon << ", " << grid.maxLon << "]" << std::endl;
+
+    grid.nLat = static_cast<int>((grid.maxLat - grid.minLat) / resolution) + 1;
+    grid.nLon = static_cast<int>((grid.maxLon - grid.minLon) / resolution) + 1;
+
+    setTimeAxis(grid);
+    return grid;
+}
+
+void Converter::setTimeAxis(GridSpec& grid) const {
+    grid.startYear = grid.startDay = -1;
+    grid.stepsPerDay = 1;
+    grid.nTime = 0;
+
+    // One time axis per file: every series must have the same step
+    const Station* reference = nullptr;
+    for (const auto& vd : m_weatherData) {
+        for (const auto& st : vd.stations) {
+            if (st.startYear == -1) continue;
+            if (!reference) {
+                reference = &st;
+            } else if (st.stepsPerDay != reference->stepsPerDay) {
+                reportMixedSteps(reference->name, reference->stepsPerDay, st.name, st.stepsPerDay);
+                return;
+            }
+        }
+    }
+    if (reference) grid.stepsPerDay = reference->stepsPerDay;
+
+    // Global start date is the earliest station start; the record runs to the latest station end
+    for (const auto& vd : m_weatherData) {
+        for (const auto& st : vd.stations) {
+            if (st.startYear == -1) continue;
+            if (grid.startYear == -1 || st.startYear < grid.startYear ||
+                (st.startYear == grid.startYear && st.startDay < grid.startDay)) {
+                grid.startYear = st.startYear;
+                grid.startDay = st.startDay;
+            }
+        }
+    }
+
+    if (grid.startYear == -1) return;
+
+    for (const auto& vd : m_weatherData) {
+        for (const auto& st : vd.stations) {
+            if (st.startYear == -1) continue;
+            grid.nTime = std::max(grid.nTime, static_cast<size_t>(stationOffset(st, grid)) + st.data.size());
+        }
+    }
+}
+
+long stationOffset(const Station& station, const GridSpec& grid) {
+    long days = Utils::dayIndex(station.startYear, station.startDay) - Utils::dayIndex(grid.startYear, grid.startDay);
+    return days * grid.stepsPerDay + station.startStep;
+}
+
+void Converter::createStationListFile() const {
     std::string filename = m_convertedDir + "/netcdf.ncw";
     std::cout << "Creating station list file: " << filename << std::endl;
     
@@ -76,22 +281,29 @@ void Converter::createStationListFile() {
         << std::put_time(localTime, "%d/%m/%Y - %H:%M:%S") 
         << " - @celray\n";
 
-    out << "name                 wgn        latitude     longitude     elevation        pcp       tmin       tmax        slr        hmd       wnd        pet     \n";
-    
-    // Check if we have PET data
-    bool hasPet = false;
-    for(const auto& vd : m_weatherData) {
-        if (vd.name == "pet") {
-            hasPet = true;
-            break;
+    // Variable columns after elevation, in netcdf.ncw order. Unselected groups are left to the
+    // weather generator, and optional variables (PET) are only marked when they were loaded.
+    std::vector<const VariableDescriptor*> columns(Variables::kVariableCount);
+    for (const auto& v : Variables::kVariables) columns[v.ncwColumn] = &v;
+    auto writeColumns = [&](bool header) {
+        for (size_t c = 0; c < columns.size(); ++c) {
+            const VariableDescriptor& v = *columns[c];
+            bool marked = isSelected(v.group) && (!v.ncwIfLoaded || variableData(v.id));
+            out << std::setw(c + 1 < columns.size() ? 11 : 10) << (header ? v.name : marked ? "1.0" : "null");
         }
-    }
+        out << (header ? "     \n" : "\n");
+    };
+
+    out << "name                 wgn        latitude     longitude     elevation";
+    writeColumns(true);
 
     // Try to read weather-sta.cli to get WGN and station list
     std::string weatherStaPath = m_txtInOutDir + "/weather-sta.cli";
-    std::ifstream staFile(weatherStaPath);
-    
-    if (staFile.is_open()) {
+    std::string weatherSta;
+    const bool archive = Archive::isArchive(m_txtInOutDir);
+
+    if (readInputFile("weather-sta.cli", weatherSta)) {
+        std::istringstream staFile(weatherSta);
         std::cout << "Reading station list from " << weatherStaPath << std::endl;
         std::string line;
         // Skip header (2 lines)
@@ -129,30 +341,25 @@ void Converter::createStationListFile() {
                 if (found) break;
             }
             
-            if (!found) {
+            // Station files of unselected groups in an archive were not parsed, only their coordinates kept
+            auto archived = m_archiveStations.find(pcpFile);
+            if (!found && archived != m_archiveStations.end()) {
+                lat = archived->second.lat;
+                lon = archived->second.lon;
+                elev = archived->second.elev;
+                found = true;
+            }
+
+            if (!found && !archive) {
                 // Try to read the file directly if not loaded
                 std::string stationFilePath = m_txtInOutDir + "/" + pcpFile;
                 std::ifstream sFile(stationFilePath);
-                if (sFile.is_open()) {
-                    std::string sLine;
-                    // Skip 2 lines
-                    std::getline(sFile, sLine);
-                    std::getline(sFile, sLine);
-                    // Read metadata line
-                    if (std::getline(sFile, sLine)) {
-                        std::stringstream sss(sLine);
-                        std::string temp;
-                        std::vector<std::string> parts;
-                        while(sss >> temp) parts.push_back(temp);
-                        if (parts.size() >= 5) {
-                            try {
-                                lat = std::stod(parts[2]);
-                                lon = std::stod(parts[3]);
-                                elev = std::stod(parts[4]);
-                                found = true;
-                            } catch (...) {}
-                        }
-                    }
+                Station station;
+                if (sFile.is_open() && readCoordinates(sFile, station)) {
+                    lat = station.lat;
+                    lon = station.lon;
+                    elev = station.elev;
+                    found = true;
                 }
             }
 
@@ -161,15 +368,8 @@ void Converter::createStationListFile() {
                     << std::right << std::setw(10) << wgn 
                     << std::setw(16) << std::fixed << std::setprecision(3) << lat
                     << std::setw(14) << lon
-                    << std::setw(14) << elev
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(10) << (hasPet ? "1.0" : "null") 
-                    << "\n";
+                    << std::setw(14) << elev;
+                writeColumns(false);
             }
         }
     } else {
@@ -187,15 +387,8 @@ void Converter::createStationListFile() {
                     << std::right << std::setw(10) << "default" 
                     << std::setw(16) << std::fixed << std::setprecision(3) << st.lat
                     << std::setw(14) << st.lon
-                    << std::setw(14) << st.elev
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(11) << "1.0" 
-                    << std::setw(10) << (hasPet ? "1.0" : "null") 
-                    << "\n";
+                    << std::setw(14) << st.elev;
+                writeColumns(false);
             }
         }
     }
@@ -204,124 +397,590 @@ void Converter::createStationListFile() {
 void Converter::readShapefile(const std::string& shapePath) {
     std::cout << "Reading shapefile: " << shapePath << std::endl;
     
+    if (shapefileExtent(shapePath, m_minLat, m_maxLat, m_minLon, m_maxLon)) {
+        std::cout << "Bounds from shapefile: " 
+                  << "Lon [" << m_minLon << ", " << m_maxLon << "], "
+                  << "Lat [" << m_minLat << ", " << m_maxLat << "]" << std::endl;
+    }
+}
+
+bool Converter::shapefileExtent(const std::string& shapePath, double& minLat, double& maxLat, double& minLon, double& maxLon) {
     GDALAllRegister();
     GDALDataset* poDS = (GDALDataset*)GDALOpenEx(shapePath.c_str(), GDAL_OF_VECTOR, NULL, NULL, NULL);
     
     if(poDS == NULL) {
         std::cerr << "Open shapefile failed." << std::endl;
-        return;
+        return false;
     }
 
+    bool found = false;
     OGRLayer* poLayer = poDS->GetLayer(0);
     if (poLayer) {
         OGREnvelope envelope;
         if (poLayer->GetExtent(&envelope) == OGRERR_NONE) {
-            m_minLon = envelope.MinX;
-            m_maxLon = envelope.MaxX;
-            m_minLat = envelope.MinY;
-            m_maxLat = envelope.MaxY;
-            std::cout << "Bounds from shapefile: " 
-                      << "Lon [" << m_minLon << ", " << m_maxLon << "], "
-                      << "Lat [" << m_minLat << ", " << m_maxLat << "]" << std::endl;
+            minLon = envelope.MinX;
+            maxLon = envelope.MaxX;
+            minLat = envelope.MinY;
+            maxLat = envelope.MaxY;
+            found = true;
         } else {
             std::cerr << "Failed to get layer extent." << std::endl;
         }
     }
     
     GDALClose(poDS);
+    return found;
+}
+
+namespace {
+
+// Exact scaling of decimal mantissas
+const double kPowersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Plain decimals such as "-12.345" are accumulated as an integer and scaled once, which
+// rounds exactly like strtod while the mantissa stays below 2^53. Exponents and longer
+// mantissas go through strtod. Returns the end of the number, or nullptr if there is none.
+const char* parseNumber(const char* p, const char* end, double& value) {
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0, scale = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p, ++digits) mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++digits, ++scale) mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+    }
+    if (digits == 0) return nullptr;
+
+    if (digits > 15 || (p < end && (*p == 'e' || *p == 'E'))) {
+        char* stop = nullptr;
+        value = std::strtod(start, &stop);
+        return stop;
+    }
+    value = static_cast<double>(mantissa) / kPowersOf10[scale];
+    if (negative) value = -value;
+    return p;
+}
+
+// Up to maxValues numbers of the row at p, separated by spaces, tabs or commas.
+// Parsing stops at the first non-number; p moves to the start of the next row.
+size_t parseRow(const char*& p, const char* end, double* values, size_t maxValues) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    if (!eol) eol = end;
+
+    size_t count = 0;
+    while (count < maxValues) {
+        while (p < eol && (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')) ++p;
+        const char* next = p < eol ? parseNumber(p, eol, values[count]) : nullptr;
+        if (!next) break;
+        p = next;
+        ++count;
+    }
+    p = eol < end ? eol + 1 : end;
+    return count;
+}
+
+// Date span of the rows of one station file
+struct RowSpan {
+    int startYear = -1, startDay = -1;
+    int firstStep = 0;
+    bool zeroStep = false; // some row has step 0
+};
+
+// Parses the data rows of a station file, "year day[ step] v0 v1 ...", appending value
+// column c of each row to series[c] when the row has it. Instantiated per column count
+// so that the row buffer and column loop are fixed at compile time.
+template <size_t Columns>
+RowSpan parseRows(const char* p, const char* end, size_t dateColumns, std::vector<double>* series) {
+    double row[3 + Columns];
+    const size_t wanted = dateColumns + Columns;
+    RowSpan span;
+    while (p < end) {
+        size_t n = parseRow(p, end, row, wanted);
+        if (n < dateColumns) continue;
+
+        if (span.startYear == -1) {
+            span.startYear = static_cast<int>(row[0]);
+            span.startDay = static_cast<int>(row[1]);
+            if (dateColumns == 3) span.firstStep = static_cast<int>(row[2]);
+        }
+        if (dateColumns == 3) span.zeroStep = span.zeroStep || row[2] == 0;
+
+        for (size_t c = 0; c < Columns && dateColumns + c < n; ++c) {
+            series[c].push_back(row[dateColumns + c]);
+        }
+    }
+    return span;
+}
+
+// Picks the parseRows instantiation for a group's column count
+template <size_t Columns = 1>
+RowSpan parseRows(size_t columns, const char* p, const char* end, size_t dateColumns, std::vector<double>* series) {
+    if constexpr (Columns < Variables::kMaxColumns) {
+        if (columns > Columns) return parseRows<Columns + 1>(columns, p, end, dateColumns, series);
+    }
+    return parseRows<Columns>(p, end, dateColumns, series);
+}
+
+// Sub-daily rows number their steps either 0..n-1 or 1..n: any step of 0 means 0..n-1
+int stepBase(bool zeroStep) {
+    return zeroStep ? 0 : 1;
+}
+
+// Steps per day from the "tstep" column of the metadata line (0 or 1 = daily)
+int stepsPerDay(const std::vector<std::string>& metadata) {
+    try {
+        return std::max(1, std::stoi(metadata[1]));
+    } catch (...) {
+        return 1;
+    }
+}
+
 }
 
 void Converter::processWeatherFiles() {
-    std::cout << "Processing text weather files..." << std::endl;
-    
-    std::vector<std::string> files = Utils::listFiles(m_txtInOutDir);
-    
-    // Check for .tem files
-    bool useTemFiles = false;
-    for (const auto& file : files) {
-        if (file.length() >= 4 && file.substr(file.length() - 4) == ".tem") {
-            useTemFiles = true;
-            break;
+    if (Archive::isArchive(m_txtInOutDir)) {
+        loadArchive();
+    } else {
+        loadWeatherFiles(weatherFileGroups());
+    }
+    m_stationsLoaded = true;
+}
+
+void Converter::restrictVariables(const std::vector<std::string>& groups) {
+    m_variables = groups;
+    const bool archive = Archive::isArchive(m_txtInOutDir);
+    auto dropped = [&](const VariableData& vd) { return !isSelected(Variables::variable(vd.id).group); };
+    for (const auto& vd : m_weatherData) {
+        if (!dropped(vd)) continue;
+
+        // netcdf.ncw still lists these stations, and an archive cannot be re-read for their coordinates
+        if (archive) {
+            for (const auto& st : vd.stations) {
+                Station& coordinates = m_archiveStations[st.name];
+                coordinates.lat = st.lat;
+                coordinates.lon = st.lon;
+                coordinates.elev = st.elev;
+            }
         }
+        if (m_spill) m_spill->remove(vd.id);
+        m_spilled[static_cast<size_t>(vd.id)] = 0;
+        m_spillQaStats.erase(std::remove_if(m_spillQaStats.begin(), m_spillQaStats.end(), [&](const VariableQaStats& stats) {
+            return stats.id == vd.id;
+        }), m_spillQaStats.end());
     }
+    m_weatherData.erase(std::remove_if(m_weatherData.begin(), m_weatherData.end(), dropped), m_weatherData.end());
+}
 
-    if (useTemFiles) {
-        std::cout << "Found .tem files. Using .tem for temperature and ignoring .tmp files." << std::endl;
+bool Converter::readInputFile(const std::string& name, std::string& content) const {
+    if (Archive::isArchive(m_txtInOutDir)) {
+        auto it = m_archiveFiles.find(name);
+        if (it == m_archiveFiles.end()) return false;
+        content = it->second;
+        return true;
     }
+    std::string path = m_txtInOutDir + "/" + name;
+    if (!std::filesystem::exists(path)) return false;
+    content = Utils::readFile(path);
+    return true;
+}
 
-    // Categorize files
-    std::map<std::string, std::vector<std::string>> fileGroups;
-    for (const auto& file : files) {
+bool Converter::isSelected(const std::string& group) const {
+    return m_variables.empty() || std::find(m_variables.begin(), m_variables.end(), group) != m_variables.end();
+}
+
+bool Converter::isSelected(WeatherGroup group) const {
+    return isSelected(Variables::group(group).name);
+}
+
+Converter::FileGroups Converter::weatherFileGroups() const {
+    std::vector<std::string> files = Utils::listFiles(m_txtInOutDir);
+
+    auto extensionOf = [](const std::string& file) {
         std::string filename = file.substr(file.find_last_of("/\\") + 1);
-        std::string ext = "";
         size_t dotPos = filename.find_last_of(".");
-        if (dotPos != std::string::npos) {
-            ext = filename.substr(dotPos);
+        return dotPos == std::string::npos ? std::string() : filename.substr(dotPos);
+    };
+
+    // A group with a preferred extension (.tem for temperature) reads only those files when any exist
+    const char* extensions[Variables::kGroupCount];
+    for (const auto& g : Variables::kGroups) {
+        extensions[static_cast<size_t>(g.id)] = g.extension;
+        if (!g.preferredExtension) continue;
+        bool found = std::any_of(files.begin(), files.end(), [&](const std::string& file) { return extensionOf(file) == g.preferredExtension; });
+        if (!found) continue;
+        extensions[static_cast<size_t>(g.id)] = g.preferredExtension;
+        if (isSelected(g.id)) {
+            std::cout << "Found " << g.preferredExtension << " files. Using " << g.preferredExtension << " for " << g.name
+                      << " and ignoring " << g.extension << " files." << std::endl;
         }
+    }
 
-        if (ext == ".pcp") fileGroups["pcp"].push_back(file);
-        else if (ext == ".slr") fileGroups["slr"].push_back(file);
-        else if (ext == ".hmd") fileGroups["hmd"].push_back(file);
-        else if (ext == ".wnd") fileGroups["wnd"].push_back(file);
-        else if (ext == ".pet") fileGroups["pet"].push_back(file);
-        else if (useTemFiles && ext == ".tem") fileGroups["tmp"].push_back(file);
-        else if (!useTemFiles && ext == ".tmp") fileGroups["tmp"].push_back(file);
+    // Categorize files; unselected groups are dropped here, before any of their files is opened
+    FileGroups fileGroups;
+    for (const auto& file : files) {
+        std::string ext = extensionOf(file);
+        for (const auto& g : Variables::kGroups) {
+            if (ext == extensions[static_cast<size_t>(g.id)] && isSelected(g.id)) {
+                fileGroups[g.id].push_back(file);
+                break;
+            }
+        }
     }
+    return fileGroups;
+}
 
-    std::vector<std::string> vars = {"pcp", "hmd", "slr", "wnd", "tmp", "pet"};
-    int secondaryEnd = vars.size();
-    int secondaryCount = 0;
+void Converter::loadWeatherFiles(const FileGroups& fileGroups) {
+    std::cout << "Processing text weather files (" << BatchReader::backendName(m_ioBackend) << " reads)..." << std::endl;
 
-    for (const auto& var : vars) {
-        const auto& groupFiles = fileGroups[var];
-        int primaryEnd = groupFiles.size();
-        int primaryCount = 0;
+    int secondaryEnd = Variables::kGroupCount;
+    int secondaryCount = 0;
 
-        if (primaryEnd == 0) {
+    for (const auto& g : Variables::kGroups) {
+        const std::string var = g.name;
+        auto group = fileGroups.find(g.id);
+        if (group == fileGroups.end()) {
             secondaryCount++;
             Utils::dualProgress(0, 0, secondaryCount, secondaryEnd, 40, "Skipping " + var);
             continue;
         }
 
-        for (const auto& file : groupFiles) {
-            if (var == "pcp") readStationFile(file, "pcp", "mm", 0);
-            else if (var == "slr") readStationFile(file, "slr", "MJ/m2", 0);
-            else if (var == "hmd") readStationFile(file, "hmd", "fraction", 0);
-            else if (var == "wnd") readStationFile(file, "wnd", "m/s", 0);
-            else if (var == "pet") readStationFile(file, "pet", "mm", 0);
-            else if (var == "tmp") {
-                readStationFile(file, "tmax", "degC", 0);
-                readStationFile(file, "tmin", "degC", 1);
-            }
+        // A group present without files still defines its variables (a tile with no nearby stations)
+        for (const auto& v : Variables::kVariables) {
+            if (v.group == g.id && !variableData(v.id)) m_weatherData.push_back({v.id, v.name, v.unit, {}});
+        }
+
+        const auto& groupFiles = group->second;
+        int primaryEnd = groupFiles.size();
+        int primaryCount = 0;
+
+        // Whole files arrive in batches from the I/O backend; each buffer is parsed once
+        BatchReader::readFiles(groupFiles, [&](size_t index, std::string& content) {
+            readStationFile(groupFiles[index], content, g);
             
+            if (m_spill) spillStations(g.id, false);
+
             primaryCount++;
             Utils::dualProgress(primaryCount, primaryEnd, secondaryCount, secondaryEnd, 40, "Parsing " + var);
-        }
+        }, m_ioBackend);
+        if (m_spill) spillStations(g.id, true);
         secondaryCount++;
         Utils::dualProgress(primaryEnd, primaryEnd, secondaryCount, secondaryEnd, 40, "Completed " + var);
     }
     std::cout << std::endl;
 }
 
-void Converter::readStationFile(const std::string& filepath, const std::string& varName, const std::string& unit, int valueColumnIndex) {
-    std::ifstream file(filepath);
-    if (!file.is_open()) return;
+void Converter::loadArchive() {
+    std::cout << "Reading weather files from archive " << m_txtInOutDir << " (single pass, no extraction)..." << std::endl;
 
-    // std::cout << "Parsing " << filepath << " for " << varName << std::endl;
+    auto groupOf = [](const std::string& filename) -> const GroupDescriptor* {
+        size_t dotPos = filename.find_last_of(".");
+        if (dotPos == std::string::npos) return nullptr;
+        std::string ext = filename.substr(dotPos);
+        for (const auto& g : Variables::kGroups) {
+            if (ext == g.extension || (g.preferredExtension && ext == g.preferredExtension)) return &g;
+        }
+        return nullptr;
+    };
 
-    // Find or create VariableData
-    auto it = std::find_if(m_weatherData.begin(), m_weatherData.end(), 
-        [&](const VariableData& vd) { return vd.name == varName; });
-    
-    if (it == m_weatherData.end()) {
-        m_weatherData.push_back({varName, unit, {}});
-        it = m_weatherData.end() - 1;
+    // Station entries go straight to the parser; every other file is kept for the model file copy
+    size_t entries = 0, parsed = 0;
+    bool complete = Archive::read(m_txtInOutDir, [&](const std::string& entry, std::string& content) {
+        ++entries;
+        std::string filename = entry.substr(entry.find_last_of("/\\") + 1);
+        const GroupDescriptor* group = groupOf(filename);
+        if (!group) {
+            // Station files already parsed are kept until the selection is narrowed to file.cio's
+            if (filename == "file.cio" && m_climateSelection) {
+                std::vector<std::string> groups = Utils::parseClimateVariables(content);
+                if (!groups.empty()) restrictVariables(groups);
+            }
+            m_archiveFiles[filename] = std::move(content);
+            return;
+        }
+        if (!isSelected(group->id)) {
+            // netcdf.ncw still lists these stations, so their coordinates are kept
+            Station station;
+            std::istringstream lines(content);
+            if (readCoordinates(lines, station)) m_archiveStations[filename] = station;
+            return;
+        }
+        readStationFile(filename, content, *group);
+        if (++parsed % 1000 == 0) std::cout << "\r  " << parsed << " station files parsed" << std::flush;
+    });
+    std::cout << "\r  " << parsed << " station files parsed, " << entries << " archive entries read" << std::endl;
+
+    if (!complete) {
+        std::cerr << "Error: Could not read all of " << m_txtInOutDir << ". Discarding its stations." << std::endl;
+        m_weatherData.clear();
+        return;
+    }
+
+    // Preferred extensions (.tem over .tmp) only become known once the whole archive has been seen
+    for (const auto& g : Variables::kGroups) {
+        if (!g.preferredExtension) continue;
+        auto hasExtension = [](const Station& st, const char* ext) {
+            size_t n = std::strlen(ext);
+            return st.name.size() >= n && st.name.compare(st.name.size() - n, n, ext) == 0;
+        };
+        bool preferred = false;
+        for (const auto& vd : m_weatherData) {
+            if (Variables::variable(vd.id).group != g.id) continue;
+            preferred = preferred || std::any_of(vd.stations.begin(), vd.stations.end(), [&](const Station& st) { return hasExtension(st, g.preferredExtension); });
+        }
+        if (!preferred) continue;
+        std::cout << "Found " << g.preferredExtension << " files. Using " << g.preferredExtension << " for " << g.name
+                  << " and ignoring " << g.extension << " files." << std::endl;
+        for (auto& vd : m_weatherData) {
+            if (Variables::variable(vd.id).group != g.id) continue;
+            vd.stations.erase(std::remove_if(vd.stations.begin(), vd.stations.end(), [&](const Station& st) {
+                return hasExtension(st, g.extension);
+            }), vd.stations.end());
+        }
+    }
+
+    // Entries arrive in archive order; variables are written in registry order
+    std::stable_sort(m_weatherData.begin(), m_weatherData.end(), [](const VariableData& a, const VariableData& b) { return a.id < b.id; });
+}
+
+bool Converter::readStationHeader(const std::string& path, StationHeader& header) const {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    // Same layout as readStationFile: metadata on the third line, then "year day value..." rows
+    std::string line;
+    if (!std::getline(file, line) || !std::getline(file, line) || !std::getline(file, line)) return false;
+
+    std::stringstream ss(line);
+    std::string temp;
+    std::vector<std::string> parts;
+    while (ss >> temp) parts.push_back(temp);
+    if (parts.size() < 5) return false;
+    try {
+        header.lat = std::stod(parts[2]);
+        header.lon = std::stod(parts[3]);
+    } catch (...) {
+        return false;
+    }
+    header.path = path;
+    header.stepsPerDay = stepsPerDay(parts);
+
+    // Rows are counted exactly as readStationFile stores them: the first dated row fixes the
+    // start and every row with a value takes the next step, whatever its own date says (gaps,
+    // repeated or trailing rows included). The file is streamed in blocks, never held whole.
+    const size_t dateColumns = header.stepsPerDay > 1 ? 3 : 2;
+    double row[4] = {0, 0, 0, 0};
+    size_t rows = 0;
+    bool zeroStep = false;
+    std::vector<char> block(1 << 20);
+    std::string pending;
+    while (file) {
+        file.read(block.data(), static_cast<std::streamsize>(block.size()));
+        if (file.gcount() <= 0) break;
+        pending.append(block.data(), static_cast<size_t>(file.gcount()));
+
+        // Only whole rows are parsed until the end of the file
+        size_t usable = pending.size();
+        if (file) {
+            size_t newline = pending.rfind('\n');
+            usable = newline == std::string::npos ? 0 : newline + 1;
+        }
+        const char* p = pending.data();
+        const char* end = p + usable;
+        while (p < end) {
+            size_t n = parseRow(p, end, row, dateColumns + 1);
+            if (n < dateColumns) continue;
+            if (header.startYear == -1) {
+                header.startYear = static_cast<int>(row[0]);
+                header.startDay = static_cast<int>(row[1]);
+                header.startStep = dateColumns == 3 ? static_cast<int>(row[2]) : 0;
+            }
+            if (dateColumns == 3) zeroStep = zeroStep || row[2] == 0;
+            rows += n > dateColumns;
+        }
+        pending.erase(0, usable);
+    }
+
+    header.count = rows;
+    if (rows == 0) {
+        header.startYear = header.startDay = -1;
+        header.startStep = 0;
+    } else if (header.stepsPerDay > 1) {
+        int base = stepBase(zeroStep);
+        header.startStep = std::min(std::max(header.startStep - base, 0), header.stepsPerDay - 1);
+    }
+    return true;
+}
+
+bool Converter::loadOutOfCore(bool hasShapefile, GridSpec& grid) {
+    if (Archive::isArchive(m_txtInOutDir)) {
+        std::cout << "--maxMemory reads station files by path; converting the archive in memory." << std::endl;
+        return false;
+    }
+
+    FileGroups groups = weatherFileGroups();
+    if (m_derivePet) groups.erase(WeatherGroup::Pet); // replaced by the derived series anyway
+
+    HeaderMap headers;
+    GridSpec axis = headerGrid(groups, headers, hasShapefile);
+
+    // Size of the parsed series in memory (doubles, one per value column; PET is derived from temperature)
+    size_t needed = 0, maxSlots = 1;
+    for (const auto& group : headers) {
+        size_t columns = Variables::group(group.first).columns + (m_derivePet && group.first == WeatherGroup::Tmp ? 1 : 0);
+        size_t perValue = sizeof(double) * columns;
+        for (const auto& header : group.second) needed += header.count * perValue;
+    }
+    for (const auto& group : groups) maxSlots = std::max(maxSlots, group.second.size());
+
+    const double mb = 1024.0 * 1024.0;
+    if (needed <= m_maxMemory || axis.startYear == -1) {
+        std::cout << "Station data (" << std::fixed << std::setprecision(1) << needed / mb << " MB) fits in --maxMemory ("
+                  << m_maxMemory / mb << " MB). Converting in memory." << std::endl;
+        return false;
+    }
+
+    // Half the budget holds parsed series waiting to be spilled (up to three per temperature
+    // station), a quarter the station values of one time block when writing
+    size_t stationBlock = std::max<size_t>(1, m_maxMemory / 2 / (axis.nTime * sizeof(double) * 3));
+    size_t timeBlock = std::max<size_t>(1, m_maxMemory / 4 / (maxSlots * sizeof(float)));
+    std::string scratchPath = m_convertedDir + "/." + m_region + ".spill";
+    m_spill = std::make_unique<SpillStore>(scratchPath, Utils::dayIndex(axis.startYear, axis.startDay), axis.stepsPerDay,
+                                           axis.nTime, stationBlock, timeBlock);
+    m_spillAxis = axis;
+
+    for (const auto& group : groups) {
+        for (const auto& v : Variables::kVariables) {
+            if (group.first == v.group && !m_spill->addVariable(v.id, group.second.size())) return false;
+        }
+    }
+    if (m_derivePet && groups.count(WeatherGroup::Tmp) && !m_spill->addVariable(VariableId::Pet, groups[WeatherGroup::Tmp].size())) return false;
+
+    std::cout << "Station data (" << std::fixed << std::setprecision(1) << needed / mb << " MB) exceeds --maxMemory ("
+              << m_maxMemory / mb << " MB). Spilling to " << scratchPath << " in blocks of "
+              << stationBlock << " stations x " << timeBlock << " time steps." << std::endl;
+
+    loadWeatherFiles(groups);
+
+    if (m_qualityEnabled) {
+        reportQualityControl(m_spillQaStats);
+    }
+    grid = axis;
+    return true;
+}
+
+void Converter::spillStations(WeatherGroup group, bool final) {
+    std::vector<VariableId> ids;
+    size_t pending = 0;
+    for (const auto& v : Variables::kVariables) {
+        VariableData* vd = variableData(v.id);
+        if (v.group != group || !vd) continue;
+        ids.push_back(v.id);
+        pending = std::max(pending, vd->stations.size() - m_spilled[static_cast<size_t>(v.id)]);
     }
+    if (pending < m_spill->stationBlock() && !final) return;
+
+    // Take the pending series out of m_weatherData; the stations stay behind as metadata
+    std::vector<VariableData> block;
+    for (VariableId id : ids) {
+        VariableData* vd = variableData(id);
+        VariableData part{vd->id, vd->name, vd->unit, {}};
+        for (size_t i = m_spilled[static_cast<size_t>(id)]; i < vd->stations.size(); ++i) {
+            std::vector<double> data;
+            data.swap(vd->stations[i].data);
+            part.stations.push_back(vd->stations[i]);
+            part.stations.back().data.swap(data);
+        }
+        block.push_back(std::move(part));
+    }
+
+    // QA and PET see the same series they would in memory, one block at a time
+    if (m_qualityEnabled) {
+        for (const auto& stats : QualityControl::run(block, m_qualityOptions)) {
+            auto total = std::find_if(m_spillQaStats.begin(), m_spillQaStats.end(),
+                [&](const VariableQaStats& s) { return s.id == stats.id; });
+            if (total == m_spillQaStats.end()) m_spillQaStats.push_back(stats);
+            else QualityControl::merge(*total, stats);
+        }
+    }
+
+    size_t& petSpilled = m_spilled[static_cast<size_t>(VariableId::Pet)];
+    VariableData pet;
+    bool derived = false;
+    if (group == WeatherGroup::Tmp && m_derivePet && m_spill->has(VariableId::Pet)) {
+        std::vector<VariableData> inputs = block;
+        if (m_petMethod == PetMethod::PriestleyTaylor) {
+            // Co-located solar radiation and humidity were spilled earlier; read those series back
+            const VariableData* tmax = inputs.empty() ? nullptr : &inputs[0];
+            for (VariableId id : {VariableId::Slr, VariableId::Hmd}) {
+                const VariableData* source = variableData(id);
+                if (!source || !tmax || !m_spill->has(id)) continue;
+                VariableData part{source->id, source->name, source->unit, {}};
+                for (size_t i = 0; i < source->stations.size(); ++i) {
+                    const Station& st = source->stations[i];
+                    bool colocated = std::any_of(tmax->stations.begin(), tmax->stations.end(), [&](const Station& t) {
+                        return std::fabs(t.lat - st.lat) <= 1e-6 && std::fabs(t.lon - st.lon) <= 1e-6;
+                    });
+                    if (!colocated || st.startYear == -1) continue;
+                    Station copy = st;
+                    copy.startYear = m_spillAxis.startYear;
+                    copy.startDay = m_spillAxis.startDay;
+                    copy.startStep = 0;
+                    copy.data = m_spill->series(id, i);
+                    part.stations.push_back(std::move(copy));
+                }
+                inputs.push_back(std::move(part));
+            }
+        }
+        derived = Evapotranspiration::derive(inputs, m_petMethod, pet);
+    }
+
+    for (const auto& part : block) {
+        size_t& spilled = m_spilled[static_cast<size_t>(part.id)];
+        m_spill->write(part.id, spilled, part.stations, 0, part.stations.size());
+        spilled += part.stations.size();
+        if (final) m_spill->fill(part.id, spilled);
+    }
+
+    if (derived) {
+        m_spill->write(VariableId::Pet, petSpilled, pet.stations, 0, pet.stations.size());
+        petSpilled += pet.stations.size();
+        if (final) m_spill->fill(VariableId::Pet, petSpilled);
+
+        VariableData* target = variableData(VariableId::Pet);
+        if (!target) {
+            m_weatherData.push_back({pet.id, pet.name, pet.unit, {}});
+            target = &m_weatherData.back();
+        }
+        for (auto& st : pet.stations) {
+            std::vector<double>().swap(st.data);
+            target->stations.push_back(std::move(st));
+        }
+    } else if (final && m_spill->has(VariableId::Pet) && group == WeatherGroup::Tmp) {
+        m_spill->fill(VariableId::Pet, petSpilled);
+    }
+}
+
+void Converter::readStationFile(const std::string& filepath, const std::string& content, const GroupDescriptor& group) {
+    // std::cout << "Parsing " << filepath << " for " << group.name << std::endl;
 
     Station station;
     station.name = filepath.substr(filepath.find_last_of("/\\") + 1);
     
+    // The buffer is scanned in place; rows are never copied into a stream
+    const char* p = content.data();
+    const char* end = p + content.size();
     std::string line;
+    auto nextLine = [&]() {
+        if (p >= end) return false;
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol) eol = end;
+        line.assign(p, eol);
+        p = eol < end ? eol + 1 : end;
+        return true;
+    };
     
     // Python logic:
     // fc = readFile(filePath)
@@ -329,13 +988,13 @@ void Converter::readStationFile(const std::string& filepath, const std::string&
     // lat = float(detailsLine[2]), lon = float(detailsLine[3]), elev = float(detailsLine[4])
     
     // Skip Line 0 and Line 1
-    if (!std::getline(file, line) || !std::getline(file, line)) {
+    if (!nextLine() || !nextLine()) {
         std::cerr << "File too short: " << filepath << std::endl;
         return;
     }
 
     // Read Line 2 (Metadata)
-    if (!std::getline(file, line)) {
+    if (!nextLine()) {
         std::cerr << "Missing metadata line in " << filepath << std::endl;
         return;
     }
@@ -358,6 +1017,7 @@ void Converter::readStationFile(const std::string& filepath, const std::string&
         std::cerr << "Error parsing coordinates in " << filepath << ": " << e.what() << std::endl;
         return;
     }
+    station.stepsPerDay = stepsPerDay(parts);
 
     // Update global bounds
     m_minLat = std::min(m_minLat, station.lat);
@@ -365,122 +1025,656 @@ void Converter::readStationFile(const std::string& filepath, const std::string&
     m_minLon = std::min(m_minLon, station.lon);
     m_maxLon = std::max(m_maxLon, station.lon);
 
-    // Read data values starting from Line 3 (4th line)
-    // Python: for line in fc[3:]:
-    bool firstLine = true;
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        
-        // Replace commas with spaces just in case
-        std::replace(line.begin(), line.end(), ',', ' ');
-        
-        std::stringstream dss(line);
-        int year, day;
-        
-        // Python: lineParts = line.strip().split()
-        // currentDate = ... (based on lineParts[0] and lineParts[1])
-        // value = float(lineParts[2 + j])
-        
-        if (!(dss >> year >> day)) continue;
+    // Data rows from Line 3 on: "year day value..." or, for sub-daily records,
+    // "year day step value..."; every value column is parsed in the same pass
+    const size_t dateColumns = station.stepsPerDay > 1 ? 3 : 2;
+    const size_t columns = static_cast<size_t>(group.columns);
+    std::vector<std::vector<double>> series(columns);
+    size_t rows = static_cast<size_t>(std::count(p, end, '\n'));
+    for (auto& values : series) values.reserve(rows);
+    RowSpan span = parseRows(columns, p, end, dateColumns, series.data());
 
-        if (firstLine) {
-            station.startYear = year;
-            station.startDay = day;
+    // One station per variable of the group, each with the values of its column
+    for (const auto& v : Variables::kVariables) {
+        if (v.group != group.id) continue;
+        VariableData* vd = variableData(v.id);
+        if (!vd) {
+            m_weatherData.push_back({v.id, v.name, v.unit, {}});
+            vd = &m_weatherData.back();
         }
-        firstLine = false;
-        
-        double val;
-        bool valFound = false;
-        
-        // Skip to the desired column (0-based index relative to value columns)
-        // The first two columns are Year and Day, so we skip those (already read)
-        // Then we skip 'valueColumnIndex' number of value columns
-        for (int i = 0; i <= valueColumnIndex; ++i) {
-            if (dss >> val) {
-                if (i == valueColumnIndex) valFound = true;
-            } else {
-                break;
+
+        Station copy = station;
+        copy.data = std::move(series[v.column]);
+        if (copy.data.empty()) {
+            copy.startYear = -1;
+            copy.startDay = -1;
+        } else {
+            copy.startYear = span.startYear;
+            copy.startDay = span.startDay;
+            if (copy.stepsPerDay > 1) {
+                copy.startStep = std::min(std::max(span.firstStep - stepBase(span.zeroStep), 0), copy.stepsPerDay - 1);
             }
         }
-        
-        if (valFound) {
-            station.data.push_back(val);
+        vd->stations.push_back(std::move(copy));
+    }
+}
+
+size_t Converter::gridVariable(const std::string& varName, const GridSpec& grid, size_t timeStart, size_t timeCount, float* out) const {
+    const VariableData* vd = findVariable(varName);
+    if (!vd || grid.startYear == -1 || timeStart >= grid.nTime) return 0;
+
+    if (m_interpolation == InterpolationMode::None) {
+        return gridStations(*vd, grid, timeStart, timeCount, out);
+    }
+    StationInterpolator interpolator(vd->stations, grid, m_interpolation);
+    return interpolateStations(*vd, interpolator, grid, timeStart, timeCount, out);
+}
+
+std::vector<long> Converter::stationOffsets(const VariableData& vd, const GridSpec& grid) const {
+    std::vector<long> offsets(vd.stations.size(), 0);
+    for (size_t s = 0; s < vd.stations.size(); ++s) {
+        const Station& station = vd.stations[s];
+        if (station.startYear != -1) {
+            offsets[s] = stationOffset(station, grid);
         }
     }
-    
-    it->stations.push_back(station);
+    return offsets;
 }
 
-void Converter::createNetCDF(const std::string& filename) {
-    std::cout << "Creating NetCDF file: " << filename << std::endl;
+size_t Converter::gridStations(const VariableData& vd, const GridSpec& grid, size_t timeStart, size_t timeCount, float* out) const {
+    timeCount = std::min(timeCount, grid.nTime - timeStart);
+    const size_t cells = grid.cellCount();
+    std::fill(out, out + timeCount * cells, kMissingValue);
+
+    std::vector<float> spilled;
+    size_t stride = 0;
+    if (m_spill && m_spill->has(vd.id)) {
+        stride = m_spill->slots(vd.id);
+        spilled.resize(timeCount * stride);
+        m_spill->read(vd.id, timeStart, timeCount, spilled.data());
+    }
+
+    std::vector<long> offsets = stationOffsets(vd, grid);
+
+    // Resolve each station's cell and time offset once rather than per time step
+    for (size_t s = 0; s < vd.stations.size(); ++s) {
+        const Station& station = vd.stations[s];
+        if (station.startYear == -1) continue;
+
+        // Direct assignment (No Interpolation): find grid cell
+        int latIdx = static_cast<int>((station.lat - grid.minLat) / grid.resolution + 0.5);
+        int lonIdx = static_cast<int>((station.lon - grid.minLon) / grid.resolution + 0.5);
+        if (latIdx < 0 || latIdx >= grid.nLat || lonIdx < 0 || lonIdx >= grid.nLon) continue;
+        size_t idx = static_cast<size_t>(latIdx) * grid.nLon + lonIdx;
+
+        if (stride > 0) {
+            for (size_t t = 0; t < timeCount; ++t) {
+                float& cell = out[t * cells + idx];
+                if (cell == kMissingValue) cell = spilled[t * stride + s];
+            }
+            continue;
+        }
+
+        long n = static_cast<long>(station.data.size());
+
+        for (size_t t = 0; t < timeCount; ++t) {
+            long localIdx = static_cast<long>(timeStart + t) - offsets[s];
+            if (localIdx < 0 || localIdx >= n) continue;
+
+            // Python: "first station wins" - only assign if currently missing
+            float& cell = out[t * cells + idx];
+            if (cell == kMissingValue) {
+                cell = static_cast<float>(station.data[localIdx]);
+            }
+        }
+    }
+    return timeCount;
+}
 
+size_t Converter::interpolateStations(const VariableData& vd, const StationInterpolator& interpolator, const GridSpec& grid, size_t timeStart, size_t timeCount, float* out,
+                                      size_t maxThreads) const {
+    timeCount = std::min(timeCount, grid.nTime - timeStart);
+    const size_t cells = grid.cellCount();
+    const size_t nStations = vd.stations.size();
+
+    std::vector<long> offsets = stationOffsets(vd, grid);
+
+    // Spilled series come back as one time-major block read from the scratch file
+    std::vector<float> spilled;
+    size_t stride = 0;
+    if (m_spill && m_spill->has(vd.id)) {
+        stride = m_spill->slots(vd.id);
+        spilled.resize(timeCount * stride);
+        m_spill->read(vd.id, timeStart, timeCount, spilled.data());
+    }
+
+    // Time steps are independent: split the block across worker threads
+    auto worker = [&](size_t first, size_t last) {
+        std::vector<float> stationValues(nStations);
+        for (size_t t = first; t < last; ++t) {
+            if (stride > 0) {
+                interpolator.apply(spilled.data() + t * stride, out + t * cells);
+                continue;
+            }
+            long globalIdx = static_cast<long>(timeStart + t);
+            for (size_t s = 0; s < nStations; ++s) {
+                const Station& station = vd.stations[s];
+                long localIdx = globalIdx - offsets[s];
+                bool inRange = station.startYear != -1 && localIdx >= 0 && localIdx < static_cast<long>(station.data.size());
+                stationValues[s] = inRange ? static_cast<float>(station.data[localIdx]) : kMissingValue;
+            }
+            interpolator.apply(stationValues.data(), out + t * cells);
+        }
+    };
+
+    size_t nThreads = std::max<size_t>(1, std::min<size_t>(maxThreads > 0 ? maxThreads : std::thread::hardware_concurrency(), timeCount));
+    if (nThreads == 1) {
+        worker(0, timeCount);
+        return timeCount;
+    }
+
+    std::vector<std::thread> threads;
+    size_t perThread = (timeCount + nThreads - 1) / nThreads;
+    for (size_t first = 0; first < timeCount; first += perThread) {
+        threads.emplace_back(worker, first, std::min(timeCount, first + perThread));
+    }
+    for (auto& th : threads) th.join();
+    return timeCount;
+}
+
+bool Converter::validateGrid(const GridSpec& grid) const {
     if (m_weatherData.empty()) {
         std::cerr << "No weather data found to write." << std::endl;
-        return;
+        return false;
     }
 
-    try {
-        NcFile dataFile(filename, NcFile::replace);
+    // Ensure positive dimensions
+    if (grid.maxLat < grid.minLat || grid.maxLon < grid.minLon) {
+        std::cerr << "Invalid bounds for grid." << std::endl;
+        return false;
+    }
 
-        // Calculate dimensions
-        // Ensure positive dimensions
-        if (m_maxLat < m_minLat || m_maxLon < m_minLon) {
-             std::cerr << "Invalid bounds for grid." << std::endl;
-             return;
-        }
+    if (grid.startYear == -1) {
+        std::cerr << "No valid dates found in data." << std::endl;
+        return false;
+    }
 
-        int nLat = static_cast<int>((m_maxLat - m_minLat) / m_resolution) + 1;
-        int nLon = static_cast<int>((m_maxLon - m_minLon) / m_resolution) + 1;
-        
-        // Determine global start date and max time steps
-        int minYear = 9999, minDay = 999;
-        bool anyData = false;
-
-        // First pass: find min date
-        for(const auto& vd : m_weatherData) {
-            for(const auto& st : vd.stations) {
-                if (st.startYear != -1) {
-                    if (st.startYear < minYear || (st.startYear == minYear && st.startDay < minDay)) {
-                        minYear = st.startYear;
-                        minDay = st.startDay;
-                        anyData = true;
-                    }
+    if (grid.nTime == 0) {
+        std::cerr << "No time steps found in data." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Converter::WriteContext Converter::prepareWrite(const GridSpec& grid, const std::vector<VariableId>& variables) const {
+    WriteContext context;
+    context.variables = variables;
+    // Neighbour weights depend only on where the reporting stations are, so variables read from the
+    // same stations (tmax/tmin always, usually every group) share one table for every block and shard
+    std::vector<std::pair<std::vector<std::array<double, 2>>, std::shared_ptr<const StationInterpolator>>> tables;
+    for (const auto& vd : m_weatherData) {
+        if (!variables.empty() && std::find(variables.begin(), variables.end(), vd.id) == variables.end()) continue;
+        if (m_interpolation != InterpolationMode::None) {
+            std::vector<std::array<double, 2>> sites;
+            for (const auto& st : vd.stations) {
+                sites.push_back(st.startYear == -1 ? std::array<double, 2>{NAN, NAN} : std::array<double, 2>{st.lat, st.lon});
+            }
+            auto same = [](const std::array<double, 2>& a, const std::array<double, 2>& b) {
+                return (std::isnan(a[0]) && std::isnan(b[0])) || a == b;
+            };
+            auto table = std::find_if(tables.begin(), tables.end(), [&](const auto& entry) {
+                return std::equal(entry.first.begin(), entry.first.end(), sites.begin(), sites.end(), same);
+            });
+            if (table == tables.end()) {
+                auto interpolator = std::make_shared<const StationInterpolator>(vd.stations, grid, m_interpolation,
+                                                                                8, 2.0, m_referenceLat);
+                context.tableBytes += interpolator->tableBytes();
+                table = tables.insert(tables.end(), {std::move(sites), std::move(interpolator)});
+            }
+            context.interpolators[vd.id] = table->second;
+        }
+        // Packing parameters come from the whole record so every shard decodes identically.
+        // A tile only sees its own stations, so tiles pack over the variable's valid range instead.
+        if (m_pack) {
+            double lo, hi;
+            PackParams params;
+            if (m_tileSpec.enabled()) {
+                // Depends only on the registry, so every tile makes the same choice
+                if (Packing::fromRange(vd.id, params)) {
+                    context.packing[vd.id] = params;
+                } else {
+                    std::cerr << "Warning: " << vd.name << " does not fit int16 at its storage precision over its valid range; "
+                              << "writing it unpacked (float) in every tile." << std::endl;
                 }
+            } else if (!m_spill || !m_spill->has(vd.id)) {
+                context.packing[vd.id] = Packing::compute(vd, kMissingValue);
+            } else if (m_spill->bounds(vd.id, lo, hi)) {
+                context.packing[vd.id] = Packing::fromBounds(vd.id, lo, hi);
+            } else {
+                context.packing[vd.id] = params;
             }
         }
-        
-        if (!anyData) {
-             std::cerr << "No valid dates found in data." << std::endl;
-             return;
-        }
-
-        // Helper to calculate offset in days
-        auto getOffset = [&](int y, int d) -> long {
-            std::tm t1 = {}; t1.tm_year = minYear - 1900; t1.tm_mday = minDay; t1.tm_mon = 0; t1.tm_isdst = -1;
-            std::tm t2 = {}; t2.tm_year = y - 1900; t2.tm_mday = d; t2.tm_mon = 0; t2.tm_isdst = -1;
-            std::time_t time1 = std::mktime(&t1);
-            std::time_t time2 = std::mktime(&t2);
-            return (long)std::difftime(time2, time1) / (60 * 60 * 24);
-        };
+    }
+    if (m_maxMemory > 0 && context.tableBytes > m_maxMemory / 4) {
+        std::cerr << "Warning: Interpolation weights (" << context.tableBytes / (1024 * 1024)
+                  << " MB) take the whole write share of --maxMemory; writing one time step per block." << std::endl;
+    }
+    return context;
+}
 
-        size_t nTime = 0;
-        for(const auto& vd : m_weatherData) {
-            for(const auto& st : vd.stations) {
-                if (st.startYear != -1) {
-                    long offset = getOffset(st.startYear, st.startDay);
-                    if (offset < 0) offset = 0; 
-                    nTime = std::max(nTime, (size_t)offset + st.data.size());
-                }
+void Converter::createNetCDF(const std::string& filename, const GridSpec& grid) const {
+    std::cout << "Creating NetCDF file: " << filename << std::endl;
+    if (!validateGrid(grid)) return;
+
+    std::cout << "Grid: " << grid.nLat << "x" << grid.nLon << ", Time steps: " << grid.nTime << std::endl;
+    std::cout << "Start Date: " << grid.startYear << ", Day " << grid.startDay << std::endl;
+    if (grid.stepsPerDay > 1) std::cout << "Time step: " << 24.0 / grid.stepsPerDay << " h" << std::endl;
+
+    if (writeTimeRange(filename, grid, 0, grid.nTime, prepareWrite(grid), true)) {
+        std::cout << "NetCDF file created successfully." << std::endl;
+    }
+}
+
+bool Converter::writeRequest(const ServeRequest& request, ServeReply& reply) const {
+    reply = ServeReply();
+    reply.output = m_convertedDir + "/" + request.output;
+
+    // parseServeRequest rejects absolute paths and ".."; a symlinked directory could still lead elsewhere
+    std::error_code ec;
+    std::filesystem::path root = std::filesystem::weakly_canonical(m_convertedDir, ec);
+    std::filesystem::path target = ec ? std::filesystem::path() : std::filesystem::weakly_canonical(reply.output, ec);
+    auto mismatch = std::mismatch(root.begin(), root.end(), target.begin(), target.end());
+    if (ec || request.output.empty() || mismatch.first != root.end() || mismatch.second == target.end()) {
+        reply.error = "output " + request.output + " is outside the output directory";
+        return false;
+    }
+
+    // Same extent rules as defineGrid, without touching the converter's own bounds
+    GridSpec grid;
+    grid.resolution = request.resolution;
+    bool buffer = false;
+    if (!request.shapePath.empty()) {
+        if (!shapefileExtent(request.shapePath, grid.minLat, grid.maxLat, grid.minLon, grid.maxLon)) {
+            reply.error = "could not read the extent of " + request.shapePath;
+            return false;
+        }
+    } else if (request.bounds.size() == 4) {
+        grid.minLat = request.bounds[0]; grid.maxLat = request.bounds[1];
+        grid.minLon = request.bounds[2]; grid.maxLon = request.bounds[3];
+    } else {
+        grid.minLat = m_minLat; grid.maxLat = m_maxLat;
+        grid.minLon = m_minLon; grid.maxLon = m_maxLon;
+        buffer = true;
+    }
+    if (grid.minLat > grid.maxLat || grid.minLon > grid.maxLon) {
+        reply.error = "invalid bounds";
+        return false;
+    }
+    if (buffer) {
+        grid.minLat -= grid.resolution; grid.maxLat += grid.resolution;
+        grid.minLon -= grid.resolution; grid.maxLon += grid.resolution;
+    }
+    grid.nLat = static_cast<int>((grid.maxLat - grid.minLat) / grid.resolution) + 1;
+    grid.nLon = static_cast<int>((grid.maxLon - grid.minLon) / grid.resolution) + 1;
+    setTimeAxis(grid);
+    if (grid.startYear == -1 || grid.nTime == 0) {
+        reply.error = "no station data loaded";
+        return false;
+    }
+
+    // The window covers whole days, clamped to the record; its time values keep the record's units
+    const long origin = Utils::dayIndex(grid.startYear, grid.startDay);
+    const long steps = grid.stepsPerDay;
+    long first = 0, last = static_cast<long>(grid.nTime) - 1;
+    long day;
+    if (!request.start.empty()) {
+        if (!Utils::parseDate(request.start, day)) { reply.error = "invalid start date " + request.start; return false; }
+        first = std::max(first, (day - origin) * steps);
+    }
+    if (!request.end.empty()) {
+        if (!Utils::parseDate(request.end, day)) { reply.error = "invalid end date " + request.end; return false; }
+        last = std::min(last, (day - origin + 1) * steps - 1);
+    }
+    if (first > last) {
+        reply.error = "the window does not overlap the record (" + Utils::formatDate(origin) + " to " +
+                      Utils::formatDate(origin + (static_cast<long>(grid.nTime) - 1) / steps) + ")";
+        return false;
+    }
+
+    // Request groups are names from the client; everything past this point works on ids
+    std::vector<VariableId> ids;
+    for (const auto& name : request.variables) {
+        const GroupDescriptor* group = Variables::findGroup(name);
+        for (const auto& v : Variables::kVariables) {
+            if (group && v.group == group->id && variableData(v.id)) ids.push_back(v.id);
+        }
+    }
+    if (!request.variables.empty() && ids.empty()) {
+        reply.error = "none of the requested variables are loaded";
+        return false;
+    }
+
+    // Concurrent requests for the same output each write their own temporary; the last rename wins
+    std::string tmpPath = Utils::temporaryFile(reply.output);
+    if (tmpPath.empty()) {
+        reply.error = "could not create a temporary file next to " + reply.output;
+        return false;
+    }
+    size_t timeCount = static_cast<size_t>(last - first + 1);
+    WriteContext context = prepareWrite(grid, ids);
+    context.threads = request.threads;
+    bool ok = writeTimeRange(tmpPath, grid, static_cast<size_t>(first), timeCount, context, false);
+    if (ok) std::filesystem::rename(tmpPath, reply.output, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(tmpPath, ec);
+        reply.error = "could not write " + reply.output;
+        return false;
+    }
+
+    reply.nLat = grid.nLat;
+    reply.nLon = grid.nLon;
+    reply.nTime = timeCount;
+    return true;
+}
+
+bool Converter::writeShards(const GridSpec& grid, const ShardSpec& spec, const std::vector<std::string>& only) const {
+    if (!validateGrid(grid)) return false;
+
+    std::vector<TimeShard> shards = timeShards(grid, spec);
+    std::vector<std::string> files;
+    std::vector<size_t> todo;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        files.push_back(m_region + "_" + shards[i].label + ".nc4");
+        if (only.empty() || std::find(only.begin(), only.end(), shards[i].label) != only.end()) {
+            todo.push_back(i);
+        }
+    }
+
+    std::cout << "Writing " << todo.size() << " of " << shards.size() << " time shards ("
+              << grid.nLat << "x" << grid.nLon << " grid)" << std::endl;
+
+    WriteContext context = prepareWrite(grid);
+
+    // Shards are independent files: workers pull the next shard until none are left.
+    // Each shard goes to a temporary name first so a failed run never leaves a truncated shard behind.
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::atomic<bool> allOk{true};
+    std::mutex progressMutex;
+
+    auto worker = [&]() {
+        for (size_t k = next++; k < todo.size(); k = next++) {
+            const TimeShard& shard = shards[todo[k]];
+            std::string finalPath = m_convertedDir + "/" + files[todo[k]];
+            std::string tmpPath = Utils::temporaryFile(finalPath);
+
+            bool ok = !tmpPath.empty() && writeTimeRange(tmpPath, grid, shard.timeStart, shard.timeCount, context, false);
+            std::error_code ec;
+            if (ok) std::filesystem::rename(tmpPath, finalPath, ec);
+            if (!ok || ec) {
+                if (!tmpPath.empty()) std::filesystem::remove(tmpPath, ec);
+                ok = false;
+                allOk = false;
             }
+
+            std::lock_guard<std::mutex> guard(progressMutex);
+            int count = static_cast<int>(++done), total = static_cast<int>(todo.size());
+            Utils::dualProgress(count, total, count, total, 40, (ok ? "Wrote " : "Failed ") + files[todo[k]]);
         }
-        
-        if (nTime == 0) {
-             std::cerr << "No time steps found in data." << std::endl;
-             return;
+    };
+
+    size_t nThreads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), todo.size()));
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nThreads; ++i) threads.emplace_back(worker);
+    for (auto& th : threads) th.join();
+
+    std::string indexPath = m_convertedDir + "/" + m_region + ".ncml";
+    if (writeShardIndex(indexPath, shards, files)) {
+        std::cout << "Shard index written to " << indexPath << std::endl;
+    } else {
+        std::cerr << "Warning: Could not write shard index " << indexPath << std::endl;
+    }
+    return allOk;
+}
+
+std::vector<bool> Converter::tileStations(const std::vector<StationHeader>& headers, const GridSpec& grid, const GridSpec& local) const {
+    std::vector<bool> keep(headers.size(), false);
+
+    if (m_interpolation == InterpolationMode::None) {
+        // Direct assignment only uses stations that fall in one of the tile's cells
+        for (size_t s = 0; s < headers.size(); ++s) {
+            if (headers[s].startYear == -1) continue;
+            int latIdx = static_cast<int>((headers[s].lat - grid.minLat) / grid.resolution + 0.5);
+            int lonIdx = static_cast<int>((headers[s].lon - grid.minLon) / grid.resolution + 0.5);
+            int latOffset = static_cast<int>((local.minLat - grid.minLat) / grid.resolution + 0.5);
+            int lonOffset = static_cast<int>((local.minLon - grid.minLon) / grid.resolution + 0.5);
+            keep[s] = latIdx >= latOffset && latIdx < latOffset + local.nLat &&
+                      lonIdx >= lonOffset && lonIdx < lonOffset + local.nLon;
+        }
+        return keep;
+    }
+
+    // Interpolated cells need exactly the stations that are among their neighbours
+    // when all stations are considered, which the header coordinates are enough to find
+    std::vector<Station> stations(headers.size());
+    for (size_t s = 0; s < headers.size(); ++s) {
+        stations[s].lat = headers[s].lat;
+        stations[s].lon = headers[s].lon;
+        stations[s].startYear = headers[s].startYear;
+        stations[s].startDay = headers[s].startDay;
+        stations[s].startStep = headers[s].startStep;
+        stations[s].stepsPerDay = headers[s].stepsPerDay;
+    }
+    StationInterpolator interpolator(stations, local, m_interpolation, 8, 2.0, m_referenceLat);
+    return interpolator.usedStations(stations.size());
+}
+
+GridSpec Converter::headerGrid(const FileGroups& groups, HeaderMap& headers, bool hasShapefile) {
+    int startYear = -1, startDay = -1;
+    long first = 0, last = 0;
+    const StationHeader* reference = nullptr;
+    bool mixed = false;
+    for (const auto& group : groups) {
+        auto& list = headers[group.first];
+        for (const auto& path : group.second) {
+            StationHeader header;
+            if (!readStationHeader(path, header)) {
+                std::cerr << "Could not read station header of " << path << std::endl;
+                continue;
+            }
+            m_minLat = std::min(m_minLat, header.lat);
+            m_maxLat = std::max(m_maxLat, header.lat);
+            m_minLon = std::min(m_minLon, header.lon);
+            m_maxLon = std::max(m_maxLon, header.lon);
+            list.push_back(header);
+        }
+    }
+
+    // Same rules as setTimeAxis: one step for every series, the axis starting at step 0 of the earliest day
+    for (const auto& group : headers) {
+        for (const auto& header : group.second) {
+            if (header.startYear == -1) continue;
+            if (!reference) {
+                reference = &header;
+            } else if (header.stepsPerDay != reference->stepsPerDay && !mixed) {
+                reportMixedSteps(reference->path, reference->stepsPerDay, header.path, header.stepsPerDay);
+                mixed = true;
+            }
+            long begin = Utils::dayIndex(header.startYear, header.startDay);
+            if (startYear == -1 || begin < first) { first = begin; startYear = header.startYear; startDay = header.startDay; }
+        }
+    }
+    const int steps = reference ? reference->stepsPerDay : 1;
+    for (const auto& group : headers) {
+        for (const auto& header : group.second) {
+            if (header.startYear == -1) continue;
+            long begin = (Utils::dayIndex(header.startYear, header.startDay) - first) * steps + header.startStep;
+            last = std::max(last, begin + static_cast<long>(header.count));
         }
+    }
+
+    GridSpec grid = defineGrid(m_resolution, hasShapefile);
+    grid.startYear = mixed ? -1 : startYear;
+    grid.startDay = startDay;
+    grid.stepsPerDay = steps;
+    grid.nTime = grid.startYear == -1 ? 0 : static_cast<size_t>(last);
+    return grid;
+}
 
-        std::cout << "Grid: " << nLat << "x" << nLon << ", Time steps: " << nTime << std::endl;
-        std::cout << "Start Date: " << minYear << ", Day " << minDay << std::endl;
+bool Converter::convertTile(double climateResolution, const std::string& shapePath) {
+    m_resolution = climateResolution;
+    const int tileCount = m_tileSpec.count();
+    std::cout << "Converting tile " << m_tileSpec.index + 1 << " of " << tileCount
+              << " (" << m_tileSpec.rows << "x" << m_tileSpec.cols << " layout)" << std::endl;
+
+    if (Archive::isArchive(m_txtInOutDir)) {
+        std::cerr << "Error: Tiles read station files by path. Extract " << m_txtInOutDir << " first." << std::endl;
+        return false;
+    }
+
+    if (!shapePath.empty()) {
+        readShapefile(shapePath);
+    }
+
+    // Pass 1: station headers only. Every tile derives the same full grid and time axis from them.
+    FileGroups groups = weatherFileGroups();
+    HeaderMap headers;
+    GridSpec grid = headerGrid(groups, headers, !shapePath.empty());
+
+    std::vector<Tile> tiles = gridTiles(grid, m_tileSpec);
+    if (tiles.empty()) {
+        std::cerr << "Error: A " << grid.nLat << "x" << grid.nLon << " grid cannot be split into "
+                  << m_tileSpec.rows << "x" << m_tileSpec.cols << " tiles." << std::endl;
+        return false;
+    }
+    const Tile& tile = tiles[m_tileSpec.index];
+    GridSpec local = tileGrid(grid, tile);
+    m_referenceLat = 0.5 * (grid.minLat + grid.maxLat);
+    std::cout << "Tile cells: lat [" << tile.latStart << ", " << tile.latStart + tile.latCount << "), lon ["
+              << tile.lonStart << ", " << tile.lonStart + tile.lonCount << ") of " << grid.nLat << "x" << grid.nLon << std::endl;
+
+    // Pass 2: parse only the stations the tile's cells draw from
+    FileGroups selected;
+    std::vector<std::pair<double, double>> temperatureSites;
+    for (const auto& group : headers) {
+        std::vector<bool> keep = tileStations(group.second, grid, local);
+        auto& files = selected[group.first];
+        for (size_t s = 0; s < keep.size(); ++s) {
+            if (!keep[s]) continue;
+            files.push_back(group.second[s].path);
+            if (group.first == WeatherGroup::Tmp) temperatureSites.push_back({group.second[s].lat, group.second[s].lon});
+        }
+    }
+
+    // Priestley-Taylor PET reads solar radiation and humidity at the temperature station itself
+    if (m_derivePet && m_petMethod == PetMethod::PriestleyTaylor) {
+        for (WeatherGroup name : {WeatherGroup::Slr, WeatherGroup::Hmd}) {
+            auto group = headers.find(name);
+            if (group == headers.end()) continue;
+            auto& files = selected[name];
+            for (const auto& header : group->second) {
+                bool colocated = std::any_of(temperatureSites.begin(), temperatureSites.end(), [&](const std::pair<double, double>& site) {
+                    return std::fabs(site.first - header.lat) <= 1e-6 && std::fabs(site.second - header.lon) <= 1e-6;
+                });
+                if (colocated && std::find(files.begin(), files.end(), header.path) == files.end()) files.push_back(header.path);
+            }
+        }
+    }
+
+    size_t total = 0, used = 0;
+    for (const auto& group : headers) total += group.second.size();
+    for (const auto& group : selected) used += group.second.size();
+    std::cout << "Reading " << used << " of " << total << " station files for this tile." << std::endl;
+
+    loadWeatherFiles(selected);
+
+    if (m_qualityEnabled) {
+        applyQualityControl();
+    }
+
+    if (m_derivePet) {
+        derivePet(m_petMethod);
+    }
+
+    if (!validateGrid(local)) return false;
+
+    WriteContext context = prepareWrite(local);
+    context.chunking = tileChunking(tile, grid.nTime);
+    context.attributes = {
+        {"tile_index", tile.index}, {"tile_count", tileCount},
+        {"tile_lat_start", tile.latStart}, {"tile_lon_start", tile.lonStart},
+        {"grid_nlat", grid.nLat}, {"grid_nlon", grid.nLon},
+    };
+
+    std::string finalPath = m_convertedDir + "/" + tileFileName(m_region, tile.index, tileCount);
+    std::string tmpPath = Utils::temporaryFile(finalPath);
+    std::cout << "Creating tile file: " << finalPath << std::endl;
+
+    std::error_code ec;
+    bool ok = !tmpPath.empty() && writeTimeRange(tmpPath, local, 0, local.nTime, context, true);
+    if (ok) std::filesystem::rename(tmpPath, finalPath, ec);
+    if (!ok || ec) {
+        if (!tmpPath.empty()) std::filesystem::remove(tmpPath, ec);
+        std::cerr << "Error: Could not write tile file " << finalPath << std::endl;
+        return false;
+    }
+    std::cout << "Tile file created successfully." << std::endl;
+    return true;
+}
+
+bool Converter::mergeTiles(int count) {
+    std::vector<std::string> files;
+    for (int i = 0; i < count; ++i) {
+        std::string path = m_convertedDir + "/" + tileFileName(m_region, i, count);
+        if (!std::filesystem::exists(path)) {
+            std::cerr << "Error: Missing tile file " << path << std::endl;
+            return false;
+        }
+        files.push_back(path);
+    }
+
+    std::string output = m_convertedDir + "/" + m_region + ".nc4";
+    std::string tmpPath = Utils::temporaryFile(output);
+    std::cout << "Merging " << count << " tiles into " << output << std::endl;
+
+    std::vector<std::pair<std::string, std::string>> variables;
+    if (!tmpPath.empty()) variables = Tiling::merge(files, tmpPath);
+    std::error_code ec;
+    if (!variables.empty()) std::filesystem::rename(tmpPath, output, ec);
+    if (variables.empty() || ec) {
+        if (!tmpPath.empty()) std::filesystem::remove(tmpPath, ec);
+        std::cerr << "Error: Could not merge tiles into " << output << std::endl;
+        return false;
+    }
+    for (const auto& path : files) std::filesystem::remove(path, ec);
+    std::cout << "NetCDF file created successfully." << std::endl;
+
+    // The merging process never loads station data; the merged variables stand in for it in the station list
+    if (m_weatherData.empty()) {
+        for (const auto& variable : variables) {
+            const VariableDescriptor* descriptor = Variables::findVariable(variable.first);
+            if (descriptor) m_weatherData.push_back({descriptor->id, variable.first, variable.second, {}});
+        }
+    }
+    std::string weatherSta;
+    if (readInputFile("weather-sta.cli", weatherSta)) {
+        createStationListFile();
+    }
+    return true;
+}
+
+bool Converter::writeTimeRange(const std::string& filename, const GridSpec& grid, size_t timeStart, size_t timeCount,
+                               const WriteContext& context, bool verbose) const {
+    // The NetCDF/HDF5 libraries are not thread-safe: every library call happens
+    // under this lock, while gridding (the expensive part) runs unlocked.
+    std::unique_lock<std::mutex> lock(s_netcdfMutex);
+
+    try {
+        NcFile dataFile(filename, NcFile::replace);
+
+        const int nLat = grid.nLat;
+        const int nLon = grid.nLon;
+        const size_t nTime = timeCount;
 
         NcDim timeDim = dataFile.addDim("time", nTime); 
         NcDim latDim = dataFile.addDim("lat", nLat);
@@ -494,111 +1688,111 @@ void Converter::createNetCDF(const std::string& filename) {
         latVar.putAtt("units", "degrees_north");
         lonVar.putAtt("units", "degrees_east");
         
-        // Set time units based on reference date
-        std::string timeUnits = "days since 1970-01-01 00:00:00.0";
-        {
-            std::tm t = {};
-            t.tm_year = minYear - 1900;
-            t.tm_mon = 0; // Jan
-            t.tm_mday = minDay; // Day of year (mktime handles > 31)
-            t.tm_isdst = -1;
-            std::mktime(&t);
-            
-            std::stringstream ss;
-            ss << "days since " 
-               << (t.tm_year + 1900) << "-" 
-               << std::setw(2) << std::setfill('0') << (t.tm_mon + 1) << "-"
-               << std::setw(2) << std::setfill('0') << t.tm_mday
-               << " 00:00:00.0";
-            timeUnits = ss.str();
-        }
-        
+        // Set time units based on reference date (shared by every shard of one conversion);
+        // sub-daily axes are counted in hours
+        const bool subDaily = grid.stepsPerDay > 1;
+        std::string timeUnits = std::string(subDaily ? "hours" : "days") + " since " +
+                                Utils::formatDate(Utils::dayIndex(grid.startYear, grid.startDay)) + " 00:00:00.0";
         timeVar.putAtt("units", timeUnits); 
         timeVar.putAtt("calendar", "gregorian");
 
+        for (const auto& attribute : context.attributes) {
+            dataFile.putAtt(attribute.first, ncInt, attribute.second);
+        }
+
         // Fill coordinates
         std::vector<double> lats(nLat);
-        for(int i=0; i<nLat; ++i) lats[i] = m_minLat + i * m_resolution;
+        for(int i=0; i<nLat; ++i) lats[i] = grid.minLat + i * grid.resolution;
         latVar.putVar(lats.data());
 
         std::vector<double> lons(nLon);
-        for(int i=0; i<nLon; ++i) lons[i] = m_minLon + i * m_resolution;
+        for(int i=0; i<nLon; ++i) lons[i] = grid.minLon + i * grid.resolution;
         lonVar.putVar(lons.data());
         
-        // Fill time
-        // Python calculates days since 1970-01-01.
-        // We need to know the start year/day from the data.
-        // Since we didn't store it in Station struct yet, let's assume a default or try to parse again?
-        // Better: Let's assume the first station's first data point corresponds to the start.
-        // And assume daily steps.
-        // NOTE: This is a simplification. Python reads actual dates.
-        // To be fully faithful, we should have stored the dates.
-        // For now, let's use a placeholder start date (e.g. 1983-01-01 from the sample file we saw)
-        // or 1970-01-01 if we treat index as days.
-        // The sample file pcp01.pcp started at 1983, day 1.
-        // Let's use a fixed start date for this prototype or 0 if we assume relative.
-        // Python uses `date2num` with `days since 1970...`.
-        
-        // Let's use a heuristic: 1970-01-01 + index days. 
-        // This is likely incorrect if the data starts in 1983.
-        // However, without refactoring Station to store dates, this is the best we can do.
+        // Fill time: steps counted from the reference date in the units string
+        const double stepLength = subDaily ? 24.0 / grid.stepsPerDay : 1.0;
         std::vector<double> times(nTime);
-        for(size_t i=0; i<nTime; ++i) times[i] = (double)i; 
+        for(size_t i=0; i<nTime; ++i) times[i] = (double)(timeStart + i) * stepLength; 
         timeVar.putVar(times.data());
 
+        // Buffer for a block of time steps
+        size_t blockSteps = std::max<size_t>(1, std::min(nTime, kWriteBlockBytes / (grid.cellCount() * sizeof(float))));
+        if (m_maxMemory > 0) {
+            // A block holds the gridded values plus one value per station and step
+            size_t stations = 1;
+            for (const auto& vd : m_weatherData) stations = std::max(stations, vd.stations.size());
+            size_t perStep = (grid.cellCount() + stations) * sizeof(float);
+            // The interpolation tables come out of the same share
+            size_t budget = m_maxMemory / 4 > context.tableBytes ? m_maxMemory / 4 - context.tableBytes : 0;
+            blockSteps = std::min(blockSteps, std::max<size_t>(1, budget / perStep));
+        }
+        if (!context.chunking.empty()) {
+            blockSteps = std::max(context.chunking[0], blockSteps / context.chunking[0] * context.chunking[0]);
+        }
+        std::vector<float> buffer(blockSteps * grid.cellCount());
+        std::vector<int16_t> packed(m_pack ? buffer.size() : 0);
+
         // Process each variable
         for (const auto& vd : m_weatherData) {
-            std::cout << "Writing variable: " << vd.name << std::endl;
-            NcVar dataVar = dataFile.addVar(vd.name, ncFloat, {timeDim, latDim, lonDim});
-            dataVar.putAtt("units", vd.unit);
-            float missingVal = -9999.0f;
-            dataVar.putAtt("missing_value", ncFloat, missingVal);
-
-            // Buffer for one time step
-            std::vector<float> buffer(nLat * nLon);
-
-            for (size_t t = 0; t < nTime; ++t) {
-                // Initialize with missing value
-                std::fill(buffer.begin(), buffer.end(), missingVal);
-
-                // Direct assignment (No Interpolation)
-                // Python: "first station wins"
-                // We iterate stations. If a cell is already filled (not missingVal), we skip.
-                for (const auto& station : vd.stations) {
-                    long offset = 0;
-                    if (station.startYear != -1) {
-                        offset = getOffset(station.startYear, station.startDay);
-                    }
-                    
-                    long localIdx = (long)t - offset;
-
-                    if (localIdx < 0 || localIdx >= station.data.size()) continue;
-                    
-                    // Find grid cell
-                    int latIdx = static_cast<int>((station.lat - m_minLat) / m_resolution + 0.5);
-                    int lonIdx = static_cast<int>((station.lon - m_minLon) / m_resolution + 0.5);
-                    
-                    if (latIdx >= 0 && latIdx < nLat && lonIdx >= 0 && lonIdx < nLon) {
-                         int idx = latIdx * nLon + lonIdx;
-                         // Only assign if currently missing (First wins)
-                         if (buffer[idx] == missingVal) {
-                             buffer[idx] = static_cast<float>(station.data[localIdx]);
-                         }
-                    }
+            if (!context.variables.empty() &&
+                std::find(context.variables.begin(), context.variables.end(), vd.id) == context.variables.end()) continue;
+            if (verbose) std::cout << "Writing variable: " << vd.name << std::endl;
+
+            auto packing = context.packing.find(vd.id);
+            const PackParams* pack = packing != context.packing.end() ? &packing->second : nullptr;
+
+            NcVar dataVar;
+            if (pack) {
+                // CF packed int16: value = packed * scale_factor + add_offset
+                dataVar = dataFile.addVar(vd.name, ncShort, {timeDim, latDim, lonDim});
+                dataVar.putAtt("units", vd.unit);
+                dataVar.putAtt("_FillValue", ncShort, Packing::kFillValue);
+                dataVar.putAtt("missing_value", ncShort, Packing::kFillValue);
+                dataVar.putAtt("scale_factor", ncFloat, static_cast<float>(pack->scale));
+                dataVar.putAtt("add_offset", ncFloat, static_cast<float>(pack->offset));
+            } else {
+                dataVar = dataFile.addVar(vd.name, ncFloat, {timeDim, latDim, lonDim});
+                dataVar.putAtt("units", vd.unit);
+                dataVar.putAtt("missing_value", ncFloat, kMissingValue);
+            }
+            if (m_interpolation != InterpolationMode::None) {
+                dataVar.putAtt("interpolation", interpolationModeName(m_interpolation));
+            }
+            if (!context.chunking.empty()) {
+                std::vector<size_t> chunks = context.chunking;
+                chunks[0] = std::min(chunks[0], nTime);
+                dataVar.setChunking(NcVar::nc_CHUNKED, chunks);
+            }
+
+            auto found = context.interpolators.find(vd.id);
+            const StationInterpolator* interpolator = found != context.interpolators.end() ? found->second.get() : nullptr;
+
+            for (size_t t = 0; t < nTime; t += blockSteps) {
+                size_t steps;
+                {
+                    ScopedUnlock unlocked(lock);
+                    steps = interpolator
+                        ? interpolateStations(vd, *interpolator, grid, timeStart + t, std::min(blockSteps, nTime - t), buffer.data(), context.threads)
+                        : gridStations(vd, grid, timeStart + t, std::min(blockSteps, nTime - t), buffer.data());
+                    if (pack) Packing::pack(buffer.data(), steps * grid.cellCount(), *pack, kMissingValue, packed.data());
                 }
 
-                // Write one time slice
+                // Write the block of time slices
                 std::vector<size_t> start = {t, 0, 0};
-                std::vector<size_t> count = {1, (size_t)nLat, (size_t)nLon};
-                dataVar.putVar(start, count, buffer.data());
+                std::vector<size_t> count = {steps, (size_t)nLat, (size_t)nLon};
+                if (pack) {
+                    dataVar.putVar(start, count, packed.data());
+                } else {
+                    dataVar.putVar(start, count, buffer.data());
+                }
             }
         }
-
-        std::cout << "NetCDF file created successfully." << std::endl;
+        return true;
 
     } catch (std::exception& e) {
-        std::cerr << "Error creating NetCDF: " << e.what() << std::endl;
+        std::cerr << "Error creating NetCDF " << filename << ": " << e.what() << std::endl;
     } catch (...) {
         std::cerr << "Unknown Error during NetCDF creation" << std::endl;
     }
+    return false;
 }
@@ -0,0 +1,223 @@
+#include "Evapotranspiration.h"
+#include "Converter.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const double kLambda = 2.45;          // latent heat of vaporization, MJ/kg
+const double kStefanBoltzmann = 4.903e-9; // MJ/K4/m2/day
+const double kPriestleyTaylorAlpha = 1.26;
+
+bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+double saturationVapourPressure(double t) {
+    return 0.6108 * std::exp(17.27 * t / (t + 237.3));
+}
+
+// Ra for every step of a series starting at (startYear, startDay), via a per-latitude day-of-year table
+std::vector<double> radiationSeries(double lat, int startYear, int startDay, size_t n) {
+    double table[366];
+    for (int d = 1; d <= 366; ++d) table[d - 1] = Evapotranspiration::extraterrestrialRadiation(lat, d);
+
+    std::vector<double> ra(n);
+    int year = startYear, day = startDay;
+    for (size_t i = 0; i < n; ++i) {
+        ra[i] = table[day - 1];
+        if (++day > (isLeapYear(year) ? 366 : 365)) { day = 1; ++year; }
+    }
+    return ra;
+}
+
+// Reporting stations of one variable sorted by latitude, so finding the station at a
+// given location is a binary search rather than a scan per temperature station
+class LocationIndex {
+public:
+    explicit LocationIndex(const VariableData* vd) {
+        if (!vd) return;
+        for (const auto& st : vd->stations) {
+            if (st.startYear != -1) m_stations.push_back(&st);
+        }
+        // stable: among co-located stations the first one listed wins, as in the station file order
+        std::stable_sort(m_stations.begin(), m_stations.end(),
+                         [](const Station* a, const Station* b) { return a->lat < b->lat; });
+    }
+
+    const Station* find(double lat, double lon) const {
+        auto it = std::lower_bound(m_stations.begin(), m_stations.end(), lat - kTolerance,
+                                   [](const Station* st, double value) { return st->lat < value; });
+        for (; it != m_stations.end() && (*it)->lat <= lat + kTolerance; ++it) {
+            if (std::fabs((*it)->lon - lon) <= kTolerance) return *it;
+        }
+        return nullptr;
+    }
+
+private:
+    static constexpr double kTolerance = 1e-6;
+    std::vector<const Station*> m_stations;
+};
+
+// Series of `st` shifted onto ref's time axis; empty if there is no co-located station
+std::vector<double> alignedSeries(const Station* st, const Station& ref, size_t n, double fill) {
+    if (!st) return {};
+    long offset = Utils::dayIndex(ref.startYear, ref.startDay) - Utils::dayIndex(st->startYear, st->startDay);
+    std::vector<double> out(n, fill);
+    for (size_t i = 0; i < n; ++i) {
+        long j = static_cast<long>(i) + offset;
+        if (j >= 0 && j < static_cast<long>(st->data.size())) out[i] = st->data[j];
+    }
+    return out;
+}
+
+const VariableData* find(const std::vector<VariableData>& weatherData, VariableId id) {
+    for (const auto& vd : weatherData) if (vd.id == id) return &vd;
+    return nullptr;
+}
+
+}
+
+bool parsePetMethod(const std::string& text, PetMethod& method) {
+    if (text == "hargreaves") method = PetMethod::Hargreaves;
+    else if (text == "priestley-taylor") method = PetMethod::PriestleyTaylor;
+    else return false;
+    return true;
+}
+
+std::string petMethodName(PetMethod method) {
+    return method == PetMethod::PriestleyTaylor ? "priestley-taylor" : "hargreaves";
+}
+
+namespace Evapotranspiration {
+
+    double extraterrestrialRadiation(double latitudeDeg, int dayOfYear) {
+        const double gsc = 0.0820; // solar constant, MJ/m2/min
+        double phi = latitudeDeg * kPi / 180.0;
+        double dr = 1.0 + 0.033 * std::cos(2.0 * kPi * dayOfYear / 365.0);
+        double delta = 0.409 * std::sin(2.0 * kPi * dayOfYear / 365.0 - 1.39);
+        double ws = std::acos(std::clamp(-std::tan(phi) * std::tan(delta), -1.0, 1.0));
+        double ra = 24.0 * 60.0 / kPi * gsc * dr *
+                    (ws * std::sin(phi) * std::sin(delta) + std::cos(phi) * std::cos(delta) * std::sin(ws));
+        return std::max(ra, 0.0);
+    }
+
+    void hargreaves(const double* tmax, const double* tmin, const double* ra, size_t n, double fill, double* pet) {
+        for (size_t i = 0; i < n; ++i) {
+            double hi = tmax[i], lo = tmin[i];
+            bool present = (hi != fill) & (lo != fill);
+            double range = std::max(hi - lo, 0.0);
+            double value = 0.0023 * (ra[i] / kLambda) * (0.5 * (hi + lo) + 17.8) * std::sqrt(range);
+            pet[i] = present ? std::max(value, 0.0) : fill;
+        }
+    }
+
+    void priestleyTaylor(const double* tmax, const double* tmin, const double* slr, const double* hmd,
+                         const double* ra, double elevation, size_t n, double fill, double* pet) {
+        double pressure = 101.3 * std::pow((293.0 - 0.0065 * elevation) / 293.0, 5.26);
+        double gamma = 0.000665 * pressure;
+        double clearSky = 0.75 + 2e-5 * elevation;
+
+        for (size_t i = 0; i < n; ++i) {
+            double hi = tmax[i], lo = tmin[i];
+            bool present = (hi != fill) & (lo != fill);
+
+            // Missing solar radiation is estimated from the temperature range (FAO-56 eq. 50),
+            // missing humidity by assuming the dew point equals tmin (FAO-56 eq. 48)
+            double range = std::max(hi - lo, 0.0);
+            double rs = (slr && slr[i] != fill) ? slr[i] : 0.16 * std::sqrt(range) * ra[i];
+            double eHi = saturationVapourPressure(hi), eLo = saturationVapourPressure(lo);
+            double ea = (hmd && hmd[i] != fill) ? hmd[i] * 0.5 * (eHi + eLo) : eLo;
+
+            double t = 0.5 * (hi + lo);
+            double slope = 4098.0 * saturationVapourPressure(t) / ((t + 237.3) * (t + 237.3));
+
+            double rso = clearSky * ra[i];
+            double relative = rso > 0.0 ? std::min(rs / rso, 1.0) : 0.0;
+            double rnl = kStefanBoltzmann * 0.5 * (std::pow(hi + 273.16, 4) + std::pow(lo + 273.16, 4)) *
+                         (0.34 - 0.14 * std::sqrt(std::max(ea, 0.0))) * (1.35 * relative - 0.35);
+            double rn = 0.77 * rs - rnl;
+
+            double value = kPriestleyTaylorAlpha * slope / (slope + gamma) * rn / kLambda;
+            pet[i] = present ? std::max(value, 0.0) : fill;
+        }
+    }
+
+    bool derive(const std::vector<VariableData>& weatherData, PetMethod method, VariableData& pet) {
+        const VariableData* tmaxData = find(weatherData, VariableId::Tmax);
+        const VariableData* tminData = find(weatherData, VariableId::Tmin);
+        if (!tmaxData || !tminData || tmaxData->stations.size() != tminData->stations.size()) return false;
+
+        // Priestley-Taylor pairs each temperature station with the slr/hmd station at its location
+        LocationIndex slrIndex(method == PetMethod::PriestleyTaylor ? find(weatherData, VariableId::Slr) : nullptr);
+        LocationIndex hmdIndex(method == PetMethod::PriestleyTaylor ? find(weatherData, VariableId::Hmd) : nullptr);
+        const double fill = Converter::kMissingValue;
+
+        const VariableDescriptor& descriptor = Variables::variable(VariableId::Pet);
+        pet.id = descriptor.id;
+        pet.name = descriptor.name;
+        pet.unit = descriptor.unit;
+        pet.stations.assign(tmaxData->stations.size(), Station());
+
+        // Day-of-year radiation needs a valid first day; such stations are reported after the workers finish
+        std::vector<char> badStart(tmaxData->stations.size(), 0);
+
+        // tmax and tmin come from the same temperature file, so stations line up by index
+        auto worker = [&](size_t first, size_t last) {
+            for (size_t s = first; s < last; ++s) {
+                const Station& hi = tmaxData->stations[s];
+                const Station& lo = tminData->stations[s];
+                Station& out = pet.stations[s];
+                out.id = hi.id;
+                out.name = hi.name;
+                out.lat = hi.lat;
+                out.lon = hi.lon;
+                out.elev = hi.elev;
+                out.startYear = hi.startYear;
+                out.startDay = hi.startDay;
+                if (hi.stepsPerDay > 1) out.startYear = -1; // the formulas are daily
+                if (out.startYear == -1) continue;
+                if (out.startDay < 1 || out.startDay > (isLeapYear(out.startYear) ? 366 : 365)) {
+                    out.startYear = -1;
+                    badStart[s] = 1;
+                    continue;
+                }
+
+                size_t n = std::min(hi.data.size(), lo.data.size());
+                std::vector<double> ra = radiationSeries(hi.lat, hi.startYear, hi.startDay, n);
+                out.data.resize(n);
+
+                if (method == PetMethod::Hargreaves) {
+                    hargreaves(hi.data.data(), lo.data.data(), ra.data(), n, fill, out.data.data());
+                } else {
+                    std::vector<double> slr = alignedSeries(slrIndex.find(hi.lat, hi.lon), hi, n, fill);
+                    std::vector<double> hmd = alignedSeries(hmdIndex.find(hi.lat, hi.lon), hi, n, fill);
+                    priestleyTaylor(hi.data.data(), lo.data.data(),
+                                    slr.empty() ? nullptr : slr.data(), hmd.empty() ? nullptr : hmd.data(),
+                                    ra.data(), hi.elev, n, fill, out.data.data());
+                }
+            }
+        };
+
+        size_t nStations = pet.stations.size();
+        size_t nThreads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), nStations));
+        std::vector<std::thread> threads;
+        size_t perThread = (nStations + nThreads - 1) / nThreads;
+        for (size_t first = 0; first < nStations; first += perThread) {
+            threads.emplace_back(worker, first, std::min(nStations, first + perThread));
+        }
+        for (auto& th : threads) th.join();
+
+        for (size_t s = 0; s < nStations; ++s) {
+            if (!badStart[s]) continue;
+            const Station& st = tmaxData->stations[s];
+            std::cerr << "Warning: " << st.name << " starts on day " << st.startDay << " of " << st.startYear
+                      << ", which does not exist. Skipping PET for this station." << std::endl;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,197 @@
+#include "Interpolator.h"
+#include "Converter.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+struct KdPoint {
+    double x, y;
+    int index;
+};
+
+}
+
+// Static 2-d tree stored in-place: the median of every range is its root.
+class StationInterpolator::KdTree {
+public:
+    explicit KdTree(std::vector<KdPoint> points) : m_points(std::move(points)) {
+        build(0, m_points.size(), 0);
+    }
+
+    // Fills result with up to k (squared distance, station index) pairs, nearest first.
+    // With values set, only stations whose value is not missing are considered.
+    void nearest(double x, double y, size_t k, std::vector<std::pair<double, int>>& result,
+                 const float* values = nullptr) const {
+        result.clear();
+        search(0, m_points.size(), 0, x, y, k, values, result);
+        std::sort_heap(result.begin(), result.end());
+    }
+
+    const std::vector<KdPoint>& points() const { return m_points; }
+
+private:
+    std::vector<KdPoint> m_points;
+
+    void build(size_t lo, size_t hi, int depth) {
+        if (hi - lo <= 1) return;
+        size_t mid = (lo + hi) / 2;
+        std::nth_element(m_points.begin() + lo, m_points.begin() + mid, m_points.begin() + hi,
+            [depth](const KdPoint& a, const KdPoint& b) { return depth % 2 == 0 ? a.x < b.x : a.y < b.y; });
+        build(lo, mid, depth + 1);
+        build(mid + 1, hi, depth + 1);
+    }
+
+    void search(size_t lo, size_t hi, int depth, double x, double y, size_t k, const float* values,
+                std::vector<std::pair<double, int>>& heap) const {
+        if (lo >= hi) return;
+        size_t mid = (lo + hi) / 2;
+        const KdPoint& p = m_points[mid];
+
+        double dx = x - p.x, dy = y - p.y;
+        double d2 = dx * dx + dy * dy;
+        if (values && values[p.index] == Converter::kMissingValue) {
+            // not a candidate, but its subtrees still are
+        } else if (heap.size() < k) {
+            heap.emplace_back(d2, p.index);
+            std::push_heap(heap.begin(), heap.end());
+        } else if (d2 < heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = {d2, p.index};
+            std::push_heap(heap.begin(), heap.end());
+        }
+
+        double diff = (depth % 2 == 0) ? dx : dy;
+        if (diff < 0) {
+            search(lo, mid, depth + 1, x, y, k, values, heap);
+            if (heap.size() < k || diff * diff < heap.front().first) search(mid + 1, hi, depth + 1, x, y, k, values, heap);
+        } else {
+            search(mid + 1, hi, depth + 1, x, y, k, values, heap);
+            if (heap.size() < k || diff * diff < heap.front().first) search(lo, mid, depth + 1, x, y, k, values, heap);
+        }
+    }
+};
+
+bool parseInterpolationMode(const std::string& text, InterpolationMode& mode) {
+    if (text == "none") mode = InterpolationMode::None;
+    else if (text == "nearest") mode = InterpolationMode::Nearest;
+    else if (text == "idw") mode = InterpolationMode::Idw;
+    else return false;
+    return true;
+}
+
+std::string interpolationModeName(InterpolationMode mode) {
+    switch (mode) {
+        case InterpolationMode::Nearest: return "nearest";
+        case InterpolationMode::Idw: return "idw";
+        default: return "none";
+    }
+}
+
+StationInterpolator::StationInterpolator(const std::vector<Station>& stations, const GridSpec& grid,
+                                         InterpolationMode mode, int neighbours, double power, double referenceLat)
+    : m_mode(mode), m_cells(grid.cellCount()), m_minLat(grid.minLat), m_minLon(grid.minLon),
+      m_resolution(grid.resolution), m_nLon(grid.nLon) {
+
+    // Work in an equirectangular projection around the grid centre so that
+    // longitude degrees are not over-weighted away from the equator.
+    const double kDegToRad = 3.14159265358979323846 / 180.0;
+    if (std::isnan(referenceLat)) referenceLat = 0.5 * (grid.minLat + grid.maxLat);
+    m_lonScale = std::cos(referenceLat * kDegToRad);
+
+    std::vector<KdPoint> points;
+    for (size_t i = 0; i < stations.size(); ++i) {
+        // Series may live outside the station (spilled to disk); startYear marks a reporting station
+        if (stations[i].startYear == -1) continue;
+        points.push_back({stations[i].lon * m_lonScale, stations[i].lat, static_cast<int>(i)});
+    }
+    if (points.empty() || m_cells == 0) return;
+
+    m_neighbours = std::min(points.size(), static_cast<size_t>(std::max(neighbours, 1)));
+    m_station.assign(m_cells * m_neighbours, 0);
+    m_weight.assign(m_cells * m_neighbours, 0.0f);
+
+    bool widen = m_mode == InterpolationMode::Nearest && m_neighbours < points.size();
+    auto shared = std::make_shared<const KdTree>(std::move(points));
+    const KdTree& tree = *shared;
+    if (widen) m_tree = shared;
+    std::vector<std::pair<double, int>> found;
+    found.reserve(m_neighbours);
+
+    for (int latIdx = 0; latIdx < grid.nLat; ++latIdx) {
+        double y = grid.minLat + latIdx * grid.resolution;
+        for (int lonIdx = 0; lonIdx < grid.nLon; ++lonIdx) {
+            double x = (grid.minLon + lonIdx * grid.resolution) * m_lonScale;
+            tree.nearest(x, y, m_neighbours, found);
+
+            size_t row = (static_cast<size_t>(latIdx) * grid.nLon + lonIdx) * m_neighbours;
+            for (size_t j = 0; j < found.size(); ++j) {
+                double d = std::max(std::sqrt(found[j].first), 1e-9);
+                m_station[row + j] = found[j].second;
+                m_weight[row + j] = static_cast<float>(1.0 / std::pow(d, power));
+            }
+        }
+    }
+}
+
+std::vector<bool> StationInterpolator::usedStations(size_t stationCount) const {
+    std::vector<bool> used(stationCount, false);
+    // A widened nearest search may reach any reporting station
+    if (m_tree) {
+        for (const KdPoint& p : m_tree->points()) {
+            if (static_cast<size_t>(p.index) < stationCount) used[p.index] = true;
+        }
+        return used;
+    }
+    for (int s : m_station) {
+        if (s >= 0 && static_cast<size_t>(s) < stationCount) used[s] = true;
+    }
+    return used;
+}
+
+void StationInterpolator::apply(const float* stationValues, float* out) const {
+    const float missing = Converter::kMissingValue;
+    const size_t k = m_neighbours;
+
+    if (k == 0) {
+        std::fill(out, out + m_cells, missing);
+        return;
+    }
+
+    if (m_mode == InterpolationMode::Nearest) {
+        // Rows are sorted nearest first: take the closest station reporting today
+        std::vector<std::pair<double, int>> found;
+        for (size_t c = 0; c < m_cells; ++c) {
+            const int* st = &m_station[c * k];
+            float value = missing;
+            for (size_t j = 0; j < k; ++j) {
+                float v = stationValues[st[j]];
+                if (v != missing) { value = v; break; }
+            }
+            if (value == missing && m_tree) {
+                // All k neighbours are silent today: the nearest reporting station further out
+                double x = (m_minLon + static_cast<double>(c % m_nLon) * m_resolution) * m_lonScale;
+                double y = m_minLat + static_cast<double>(c / m_nLon) * m_resolution;
+                m_tree->nearest(x, y, 1, found, stationValues);
+                if (!found.empty()) value = stationValues[found[0].second];
+            }
+            out[c] = value;
+        }
+        return;
+    }
+
+    for (size_t c = 0; c < m_cells; ++c) {
+        const int* st = &m_station[c * k];
+        const float* w = &m_weight[c * k];
+        float num = 0.0f, den = 0.0f;
+        for (size_t j = 0; j < k; ++j) {
+            float v = stationValues[st[j]];
+            bool ok = (v != missing);
+            float wj = ok ? w[j] : 0.0f;
+            num += wj * (ok ? v : 0.0f);
+            den += wj;
+        }
+        out[c] = (den > 0.0f) ? num / den : missing;
+    }
+}
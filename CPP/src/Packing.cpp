@@ -0,0 +1,83 @@
+#include "Packing.h"
+#include "Converter.h"
+#include "QualityControl.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double kPackedSpan = 65534.0; // number of steps in [-32767, 32767]
+
+}
+
+namespace Packing {
+
+    double precision(VariableId id) {
+        return Variables::variable(id).precision;
+    }
+
+    PackParams compute(const VariableData& vd, double fill) {
+        const double none = std::numeric_limits<double>::max();
+        double lo = none;
+        double hi = -none;
+
+        // Fill values are blended to the reduction's identity; `omp simd` lets the
+        // min/max reduction be reordered, which GCC needs before it vectorizes it
+        for (const auto& st : vd.stations) {
+            const double* v = st.data.data();
+            double stLo = lo, stHi = hi;
+            #pragma omp simd reduction(min:stLo) reduction(max:stHi)
+            for (size_t i = 0; i < st.data.size(); ++i) {
+                bool present = (v[i] != fill);
+                stLo = std::min(stLo, present ? v[i] : none);
+                stHi = std::max(stHi, present ? v[i] : -none);
+            }
+            lo = stLo;
+            hi = stHi;
+        }
+
+        if (lo > hi) return PackParams(); // no data
+
+        // Interpolated values are convex combinations of station values, so the
+        // station range bounds the gridded range too.
+        return fromBounds(vd.id, lo, hi);
+    }
+
+    PackParams fromBounds(VariableId id, double lo, double hi) {
+        PackParams params;
+        double step = precision(id);
+        if (step > 0.0 && (hi - lo) / step <= kPackedSpan) {
+            params.scale = step;
+            params.offset = std::round(0.5 * (lo + hi) / step) * step;
+        } else {
+            params.scale = (hi > lo) ? (hi - lo) / kPackedSpan : 1.0;
+            params.offset = 0.5 * (lo + hi);
+        }
+        return params;
+    }
+
+    bool fromRange(VariableId id, PackParams& params) {
+        ValidRange range = validRange(id);
+        double step = precision(id);
+        if (step <= 0.0 || (range.max - range.min) / step > kPackedSpan) return false;
+        params.scale = step;
+        params.offset = std::round(0.5 * (range.min + range.max) / step) * step;
+        return true;
+    }
+
+    void pack(const float* in, size_t n, const PackParams& params, float fill, int16_t* out) {
+        const float invScale = static_cast<float>(1.0 / params.scale);
+        const float offset = static_cast<float>(params.offset);
+        // Round half away from zero, clamp, then blend in the fill value: all selects on
+        // float lanes, so the loop vectorizes (rounding before clamping keeps the same results)
+        for (size_t i = 0; i < n; ++i) {
+            float x = in[i];
+            float q = (x - offset) * invScale;
+            q += std::copysign(0.5f, q);
+            q = std::min(std::max(q, -32767.0f), 32767.0f);
+            q = (x == fill) ? static_cast<float>(kFillValue) : q;
+            out[i] = static_cast<int16_t>(static_cast<int32_t>(q));
+        }
+    }
+}
@@ -0,0 +1,230 @@
+#include "QualityControl.h"
+#include "Converter.h"
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// Series are processed in cache-sized chunks so the sentinel and range kernels
+// touch each value while it is still in L1. The loops are branch-free (compare +
+// select + count); GCC only vectorizes their count and min/max reductions when
+// told the reduction may be reordered, hence `omp simd` (built with -fopenmp-simd).
+const size_t kChunk = 4096;
+
+size_t normalizeSentinels(double* v, size_t n, const std::vector<double>& sentinels, double fill) {
+    size_t replaced = 0;
+    for (double s : sentinels) {
+        #pragma omp simd reduction(+:replaced)
+        for (size_t i = 0; i < n; ++i) {
+            bool hit = (v[i] == s);
+            replaced += hit;
+            v[i] = hit ? fill : v[i];
+        }
+    }
+    return replaced;
+}
+
+template <RangeAction Action>
+void checkRange(double* v, size_t n, ValidRange range, double fill, size_t& below, size_t& above) {
+    size_t lo = 0, hi = 0;
+    #pragma omp simd reduction(+:lo, hi)
+    for (size_t i = 0; i < n; ++i) {
+        double x = v[i];
+        bool present = (x != fill);
+        bool isBelow = present & (x < range.min);
+        bool isAbove = present & (x > range.max);
+        lo += isBelow;
+        hi += isAbove;
+        if (Action == RangeAction::Clip) {
+            v[i] = isBelow ? range.min : (isAbove ? range.max : x);
+        } else if (Action == RangeAction::Mask) {
+            v[i] = (isBelow | isAbove) ? fill : x;
+        }
+    }
+    below += lo;
+    above += hi;
+}
+
+template <RangeAction Action>
+size_t checkTemperaturePair(double* tmax, double* tmin, size_t n, double fill) {
+    size_t bad = 0;
+    #pragma omp simd reduction(+:bad)
+    for (size_t i = 0; i < n; ++i) {
+        double hiT = tmax[i], loT = tmin[i];
+        bool swapped = (hiT != fill) & (loT != fill) & (loT > hiT);
+        bad += swapped;
+        if (Action == RangeAction::Clip) {
+            tmax[i] = swapped ? loT : hiT;
+            tmin[i] = swapped ? hiT : loT;
+        } else if (Action == RangeAction::Mask) {
+            tmax[i] = swapped ? fill : hiT;
+            tmin[i] = swapped ? fill : loT;
+        }
+    }
+    return bad;
+}
+
+void summarize(const double* v, size_t n, double fill, size_t& missing, double& minVal, double& maxVal) {
+    const double none = std::numeric_limits<double>::max();
+    size_t miss = 0;
+    double lo = none;
+    double hi = -none;
+    // Fill values are blended to the reduction's identity, not skipped
+    #pragma omp simd reduction(+:miss) reduction(min:lo) reduction(max:hi)
+    for (size_t i = 0; i < n; ++i) {
+        bool isMissing = (v[i] == fill);
+        miss += isMissing;
+        lo = std::min(lo, isMissing ? none : v[i]);
+        hi = std::max(hi, isMissing ? -none : v[i]);
+    }
+    missing += miss;
+    minVal = std::min(minVal, lo);
+    maxVal = std::max(maxVal, hi);
+}
+
+template <RangeAction Action>
+void processSeries(std::vector<double>& series, const QualityOptions& options, ValidRange range,
+                   double fill, VariableQaStats& stats) {
+    double* v = series.data();
+    size_t n = series.size();
+    for (size_t base = 0; base < n; base += kChunk) {
+        size_t len = std::min(kChunk, n - base);
+        stats.sentinels += normalizeSentinels(v + base, len, options.sentinels, fill);
+        checkRange<Action>(v + base, len, range, fill, stats.belowRange, stats.aboveRange);
+    }
+    stats.values += n;
+}
+
+template <RangeAction Action>
+std::vector<VariableQaStats> runWith(std::vector<VariableData>& weatherData, const QualityOptions& options) {
+    const double fill = Converter::kMissingValue;
+    std::vector<VariableQaStats> allStats;
+
+    for (auto& vd : weatherData) {
+        VariableQaStats stats;
+        stats.id = vd.id;
+        stats.name = vd.name;
+        ValidRange range = validRange(vd.id);
+        for (auto& st : vd.stations) {
+            processSeries<Action>(st.data, options, range, fill, stats);
+        }
+        allStats.push_back(stats);
+    }
+
+    // tmax and tmin come from the same .tmp/.tem file, so stations line up by index
+    VariableData* tmaxData = nullptr;
+    VariableData* tminData = nullptr;
+    VariableQaStats* tmaxStats = nullptr;
+    VariableQaStats* tminStats = nullptr;
+    for (size_t i = 0; i < weatherData.size(); ++i) {
+        if (weatherData[i].id == VariableId::Tmax) { tmaxData = &weatherData[i]; tmaxStats = &allStats[i]; }
+        if (weatherData[i].id == VariableId::Tmin) { tminData = &weatherData[i]; tminStats = &allStats[i]; }
+    }
+    if (tmaxData && tminData && tmaxData->stations.size() == tminData->stations.size()) {
+        size_t bad = 0;
+        for (size_t s = 0; s < tmaxData->stations.size(); ++s) {
+            auto& hi = tmaxData->stations[s];
+            auto& lo = tminData->stations[s];
+            if (hi.name != lo.name) continue;
+            size_t n = std::min(hi.data.size(), lo.data.size());
+            bad += checkTemperaturePair<Action>(hi.data.data(), lo.data.data(), n, fill);
+        }
+        tmaxStats->inconsistent = bad;
+        tminStats->inconsistent = bad;
+    }
+
+    for (size_t i = 0; i < weatherData.size(); ++i) {
+        VariableQaStats& stats = allStats[i];
+        stats.min = std::numeric_limits<double>::max();
+        stats.max = std::numeric_limits<double>::lowest();
+        for (const auto& st : weatherData[i].stations) {
+            summarize(st.data.data(), st.data.size(), fill, stats.missing, stats.min, stats.max);
+        }
+        if (stats.min > stats.max) stats.min = stats.max = fill;
+    }
+    return allStats;
+}
+
+}
+
+bool parseRangeAction(const std::string& text, RangeAction& action) {
+    if (text == "flag") action = RangeAction::Flag;
+    else if (text == "clip") action = RangeAction::Clip;
+    else if (text == "mask") action = RangeAction::Mask;
+    else return false;
+    return true;
+}
+
+std::string rangeActionName(RangeAction action) {
+    switch (action) {
+        case RangeAction::Clip: return "clip";
+        case RangeAction::Mask: return "mask";
+        default: return "flag";
+    }
+}
+
+ValidRange validRange(VariableId id) {
+    const VariableDescriptor& descriptor = Variables::variable(id);
+    return {descriptor.validMin, descriptor.validMax};
+}
+
+namespace QualityControl {
+
+    std::vector<VariableQaStats> run(std::vector<VariableData>& weatherData, const QualityOptions& options) {
+        switch (options.action) {
+            case RangeAction::Clip: return runWith<RangeAction::Clip>(weatherData, options);
+            case RangeAction::Mask: return runWith<RangeAction::Mask>(weatherData, options);
+            default: return runWith<RangeAction::Flag>(weatherData, options);
+        }
+    }
+
+    void merge(VariableQaStats& total, const VariableQaStats& part) {
+        bool totalHasData = total.values > total.missing;
+        bool partHasData = part.values > part.missing;
+        total.values += part.values;
+        total.sentinels += part.sentinels;
+        total.missing += part.missing;
+        total.belowRange += part.belowRange;
+        total.aboveRange += part.aboveRange;
+        total.inconsistent += part.inconsistent;
+        if (partHasData) {
+            total.min = totalHasData ? std::min(total.min, part.min) : part.min;
+            total.max = totalHasData ? std::max(total.max, part.max) : part.max;
+        }
+    }
+
+    bool writeReport(const std::string& path, const std::vector<VariableQaStats>& stats, const QualityOptions& options) {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+
+        std::time_t now = std::time(nullptr);
+        std::tm* localTime = std::localtime(&now);
+        out << "qa_report.txt: written by swat-netcdf converter (C++) "
+            << std::put_time(localTime, "%d/%m/%Y - %H:%M:%S") << "\n";
+
+        out << "sentinels:";
+        for (double s : options.sentinels) out << " " << s;
+        out << "   fill: " << Converter::kMissingValue << "   out-of-range action: " << rangeActionName(options.action) << "\n";
+
+        out << std::left << std::setw(10) << "variable" << std::right
+            << std::setw(14) << "values" << std::setw(12) << "sentinels" << std::setw(12) << "missing"
+            << std::setw(12) << "below" << std::setw(12) << "above" << std::setw(12) << "tmin>tmax"
+            << std::setw(12) << "min" << std::setw(12) << "max" << "\n";
+
+        for (const auto& s : stats) {
+            ValidRange range = validRange(s.id);
+            out << std::left << std::setw(10) << s.name << std::right
+                << std::setw(14) << s.values << std::setw(12) << s.sentinels << std::setw(12) << s.missing
+                << std::setw(12) << s.belowRange << std::setw(12) << s.aboveRange << std::setw(12) << s.inconsistent
+                << std::setw(12) << std::fixed << std::setprecision(3) << s.min
+                << std::setw(12) << s.max;
+            out << "   valid [" << range.min << ", " << range.max << "]";
+            out << "\n";
+        }
+        return out.good();
+    }
+}
@@ -0,0 +1,485 @@
+#include "Server.h"
+#include "Converter.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SWAT2NETCDF_UNIX_SOCKETS
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// The subset of JSON requests use: one object of strings, numbers, booleans and flat arrays
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> fields;
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_text(text) {}
+
+    bool parse(JsonValue& value) {
+        if (!parseValue(value, 0)) return false;
+        skipSpace();
+        return m_pos == m_text.size();
+    }
+
+private:
+    const std::string& m_text;
+    size_t m_pos = 0;
+
+    void skipSpace() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) ++m_pos;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) { ++m_pos; return true; }
+        return false;
+    }
+
+    bool literal(const char* word) {
+        size_t n = std::strlen(word);
+        if (m_text.compare(m_pos, n, word) != 0) return false;
+        m_pos += n;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos++];
+            if (c == '"') return true;
+            if (c != '\\') { out += c; continue; }
+            if (m_pos >= m_text.size()) return false;
+            char e = m_text[m_pos++];
+            switch (e) {
+                case '"': case '\\': case '/': out += e; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    // Paths and names are ASCII in practice; other code points are kept as UTF-8
+                    if (m_pos + 4 > m_text.size() ||
+                        !std::all_of(m_text.begin() + m_pos, m_text.begin() + m_pos + 4, [](char h) { return std::isxdigit(static_cast<unsigned char>(h)) != 0; })) {
+                        return false;
+                    }
+                    unsigned code = std::stoul(m_text.substr(m_pos, 4), nullptr, 16);
+                    m_pos += 4;
+                    if (code < 0x80) out += static_cast<char>(code);
+                    else if (code < 0x800) { out += static_cast<char>(0xC0 | (code >> 6)); out += static_cast<char>(0x80 | (code & 0x3F)); }
+                    else { out += static_cast<char>(0xE0 | (code >> 12)); out += static_cast<char>(0x80 | ((code >> 6) & 0x3F)); out += static_cast<char>(0x80 | (code & 0x3F)); }
+                    break;
+                }
+                default: return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > 8) return false;
+        skipSpace();
+        if (m_pos >= m_text.size()) return false;
+        char c = m_text[m_pos];
+        if (c == '{') {
+            ++m_pos;
+            value.type = JsonValue::Object;
+            if (consume('}')) return true;
+            do {
+                std::string key;
+                if (!parseString(key) || !consume(':') || !parseValue(value.fields[key], depth + 1)) return false;
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            ++m_pos;
+            value.type = JsonValue::Array;
+            if (consume(']')) return true;
+            do {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1)) return false;
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            value.type = JsonValue::String;
+            return parseString(value.text);
+        }
+        if (literal("true")) { value.type = JsonValue::Bool; value.boolean = true; return true; }
+        if (literal("false")) { value.type = JsonValue::Bool; value.boolean = false; return true; }
+        if (literal("null")) { value.type = JsonValue::Null; return true; }
+
+        const char* begin = m_text.c_str() + m_pos;
+        char* end = nullptr;
+        value.number = std::strtod(begin, &end);
+        if (end == begin) return false;
+        value.type = JsonValue::Number;
+        m_pos += static_cast<size_t>(end - begin);
+        return true;
+    }
+};
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    out += code;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+std::string errorReply(const std::string& error) {
+    return "{\"ok\": false, \"error\": " + jsonString(error) + "}";
+}
+
+// Variables, station counts and record span of the loaded data
+std::string statusReply(const Converter& converter, size_t served) {
+    std::stringstream out;
+    out << "{\"ok\": true, \"variables\": {";
+    long first = 0, last = -1;
+    bool any = false;
+    const auto& weatherData = converter.weatherData();
+    for (size_t i = 0; i < weatherData.size(); ++i) {
+        const VariableData& vd = weatherData[i];
+        out << (i ? ", " : "") << jsonString(vd.name) << ": " << vd.stations.size();
+        for (const auto& st : vd.stations) {
+            if (st.startYear == -1 || st.data.empty()) continue;
+            long start = Utils::dayIndex(st.startYear, st.startDay);
+            long end = start + (st.startStep + static_cast<long>(st.data.size()) - 1) / st.stepsPerDay;
+            first = any ? std::min(first, start) : start;
+            last = any ? std::max(last, end) : end;
+            any = true;
+        }
+    }
+    out << "}";
+    if (any) out << ", \"start\": " << jsonString(Utils::formatDate(first)) << ", \"end\": " << jsonString(Utils::formatDate(last));
+    out << ", \"served\": " << served << "}";
+    return out.str();
+}
+
+} // namespace
+
+bool parseServeRequest(const std::string& json, ServeRequest& request, std::string& error) {
+    JsonValue root;
+    if (!JsonParser(json).parse(root) || root.type != JsonValue::Object) {
+        error = "request is not a JSON object";
+        return false;
+    }
+
+    request = ServeRequest();
+    for (const auto& field : root.fields) {
+        const std::string& key = field.first;
+        const JsonValue& value = field.second;
+        if (key == "output" && value.type == JsonValue::String) {
+            request.output = value.text;
+        } else if (key == "resolution" && value.type == JsonValue::Number && value.number > 0) {
+            request.resolution = value.number;
+        } else if (key == "shapePath" && value.type == JsonValue::String) {
+            request.shapePath = value.text;
+        } else if (key == "start" && value.type == JsonValue::String) {
+            request.start = value.text;
+        } else if (key == "end" && value.type == JsonValue::String) {
+            request.end = value.text;
+        } else if (key == "bounds" && value.type == JsonValue::Array && value.items.size() == 4) {
+            for (const auto& item : value.items) {
+                if (item.type != JsonValue::Number) { error = "bounds must be [minLat, maxLat, minLon, maxLon]"; return false; }
+                request.bounds.push_back(item.number);
+            }
+        } else if (key == "variables" && (value.type == JsonValue::String || value.type == JsonValue::Array)) {
+            // "pcp,tmp" or ["pcp", "tmp"]
+            std::string list = value.text;
+            for (const auto& item : value.items) {
+                if (item.type != JsonValue::String) { error = "variables must be strings"; return false; }
+                list += (list.empty() ? "" : ",") + item.text;
+            }
+            // An empty list selects every loaded variable, as on the command line
+            if (!list.empty() && !Utils::parseVariableList(list, request.variables)) { error = "unknown variables '" + list + "'"; return false; }
+        } else if (key != "command") {
+            error = "invalid field '" + key + "'";
+            return false;
+        }
+    }
+    if (request.output.empty()) {
+        error = "missing output";
+        return false;
+    }
+    // Clients only write inside the server's output directory
+    std::filesystem::path output(request.output);
+    bool escapes = output.is_absolute() || output.has_root_name() ||
+                   std::any_of(output.begin(), output.end(), [](const std::filesystem::path& part) { return part == ".."; });
+    if (escapes || !output.has_filename()) {
+        error = "output must be a file name relative to the output directory";
+        return false;
+    }
+    return true;
+}
+
+namespace Server {
+
+#ifdef SWAT2NETCDF_UNIX_SOCKETS
+
+bool run(const Converter& converter, const std::string& socketPath, size_t workers) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path is too long: " << socketPath << std::endl;
+        return false;
+    }
+
+    // A socket left behind by a server that did not shut down cleanly is replaced
+    std::error_code ec;
+    if (std::filesystem::exists(socketPath, ec)) {
+        if (!std::filesystem::is_socket(socketPath, ec)) {
+            std::cerr << "Error: " << socketPath << " exists and is not a socket." << std::endl;
+            return false;
+        }
+        std::filesystem::remove(socketPath, ec);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: Could not create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        std::cerr << "Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return false;
+    }
+
+    // A client that disconnects early must not take the server down with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Connections with a complete request line wait for a worker; between requests they go back to
+    // the polling loop, so an idle client never holds a worker.
+    struct Connection {
+        int fd;
+        std::string buffer; // received and not yet answered
+        bool closed;        // the client has shut down its side
+    };
+    std::deque<Connection> pending, returned;
+    std::mutex queueMutex, logMutex;
+    std::condition_variable queued;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> served{0};
+
+    // Workers wake the polling loop when they hand a connection back or stop the server
+    int wake[2];
+    if (pipe(wake) != 0) {
+        std::cerr << "Error: Could not create the server's wake-up pipe: " << std::strerror(errno) << std::endl;
+        close(listener);
+        std::filesystem::remove(socketPath, ec);
+        return false;
+    }
+    // Neither end ever blocks: a full pipe already guarantees a wake-up
+    fcntl(wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake[1], F_SETFL, O_NONBLOCK);
+    auto wakeUp = [&]() {
+        char byte = 0;
+        (void)!write(wake[1], &byte, 1);
+    };
+
+    auto sendLine = [](int fd, const std::string& line) {
+        std::string data = line + "\n";
+        for (size_t sent = 0; sent < data.size();) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    };
+
+    auto answer = [&](const std::string& line) {
+        auto started = std::chrono::steady_clock::now();
+        JsonValue root;
+        bool parsed = JsonParser(line).parse(root) && root.type == JsonValue::Object;
+        auto command = parsed ? root.fields.find("command") : root.fields.end();
+        if (parsed && command != root.fields.end() && command->second.text == "status") {
+            return statusReply(converter, served);
+        }
+        if (parsed && command != root.fields.end() && command->second.text == "stop") {
+            stopping = true;
+            wakeUp();
+            return std::string("{\"ok\": true}");
+        }
+        if (parsed && command != root.fields.end()) {
+            return errorReply("unknown command '" + command->second.text + "'");
+        }
+
+        ServeRequest request;
+        ServeReply result;
+        std::string error;
+        // Requests on all workers share the cores instead of each starting one thread per core
+        bool valid = parseServeRequest(line, request, error);
+        request.threads = std::max<size_t>(1, std::thread::hardware_concurrency() / workers);
+        if (!valid) return errorReply(error);
+        if (!converter.writeRequest(request, result)) return errorReply(result.error);
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        std::stringstream out;
+        out << "{\"ok\": true, \"output\": " << jsonString(result.output)
+            << ", \"nLat\": " << result.nLat << ", \"nLon\": " << result.nLon << ", \"nTime\": " << result.nTime
+            << ", \"seconds\": " << seconds << "}";
+        ++served;
+        std::lock_guard<std::mutex> guard(logMutex);
+        std::cout << "Wrote " << result.output << " (" << result.nLat << "x" << result.nLon << ", "
+                  << result.nTime << " steps) in " << seconds << " s" << std::endl;
+        return out.str();
+    };
+
+    // Answers the complete lines received so far (a closed connection's last line needs no newline),
+    // then closes the connection or returns it to the polling loop
+    auto handle = [&](Connection connection) {
+        bool open = true;
+        while (open && !stopping) {
+            size_t newline = connection.buffer.find('\n');
+            if (newline == std::string::npos) {
+                if (!connection.closed || connection.buffer.find_first_not_of(" \t\r\n") == std::string::npos) break;
+                newline = connection.buffer.size();
+            }
+            std::string line = connection.buffer.substr(0, newline);
+            connection.buffer.erase(0, std::min(connection.buffer.size(), newline + 1));
+            if (line.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+            open = sendLine(connection.fd, answer(line));
+        }
+        if (!open || connection.closed || stopping) {
+            close(connection.fd);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(queueMutex);
+        returned.push_back(std::move(connection));
+        wakeUp();
+    };
+
+    auto worker = [&]() {
+        while (true) {
+            Connection connection;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queued.wait(lock, [&] { return stopping || !pending.empty(); });
+                if (pending.empty()) return;
+                connection = std::move(pending.front());
+                pending.pop_front();
+            }
+            handle(std::move(connection));
+        }
+    };
+
+    workers = std::max<size_t>(1, workers);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; ++i) threads.emplace_back(worker);
+    std::cout << "Serving on " << socketPath << " with " << workers << " workers." << std::endl;
+
+    // One loop polls the listener and every idle connection; a connection goes to the workers
+    // once it holds a complete request line or its client has shut down
+    std::vector<Connection> idle;
+    std::vector<pollfd> watched;
+    char chunk[4096];
+    while (!stopping) {
+        {
+            std::lock_guard<std::mutex> guard(queueMutex);
+            for (auto& connection : returned) idle.push_back(std::move(connection));
+            returned.clear();
+        }
+        watched.assign({{listener, POLLIN, 0}, {wake[0], POLLIN, 0}});
+        for (const auto& connection : idle) watched.push_back({connection.fd, POLLIN, 0});
+        if (poll(watched.data(), watched.size(), 200) <= 0) continue;
+
+        if (watched[1].revents) {
+            char drained[64];
+            while (read(wake[0], drained, sizeof(drained)) > 0) {}
+        }
+        std::vector<Connection> ready, waiting;
+        for (size_t i = 0; i < idle.size(); ++i) {
+            Connection& connection = idle[i];
+            if (watched[i + 2].revents) {
+                ssize_t n = recv(connection.fd, chunk, sizeof(chunk), 0);
+                if (n > 0) connection.buffer.append(chunk, static_cast<size_t>(n));
+                else connection.closed = true;
+            }
+            bool complete = connection.closed || connection.buffer.find('\n') != std::string::npos;
+            (complete ? ready : waiting).push_back(std::move(connection));
+        }
+        idle = std::move(waiting);
+        if (watched[0].revents) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0) idle.push_back({client, "", false});
+        }
+        if (!ready.empty()) {
+            std::lock_guard<std::mutex> guard(queueMutex);
+            for (auto& connection : ready) pending.push_back(std::move(connection));
+            queued.notify_all();
+        }
+    }
+
+    close(listener);
+    std::filesystem::remove(socketPath, ec);
+    for (const auto& connection : idle) close(connection.fd);
+    {
+        std::lock_guard<std::mutex> guard(queueMutex);
+        for (const auto& connection : pending) close(connection.fd);
+        pending.clear();
+    }
+    queued.notify_all();
+    for (auto& th : threads) th.join();
+    for (const auto& connection : returned) close(connection.fd);
+    close(wake[0]);
+    close(wake[1]);
+    std::cout << "Server stopped after " << served << " requests." << std::endl;
+    return true;
+}
+
+#else
+
+bool run(const Converter&, const std::string& socketPath, size_t) {
+    std::cerr << "Error: --serve needs Unix domain sockets, which this build does not support (" << socketPath << ")." << std::endl;
+    return false;
+}
+
+#endif
+
+}
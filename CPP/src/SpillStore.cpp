@@ -0,0 +1,182 @@
+#include "SpillStore.h"
+#include "Converter.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SWAT2NETCDF_MMAP_SPILL
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool parseMemorySize(const std::string& text, size_t& bytes) {
+    try {
+        size_t used = 0;
+        double value = std::stod(text, &used);
+        std::string suffix = text.substr(used);
+        double scale = 1.0;
+        if (suffix == "K" || suffix == "k") scale = 1024.0;
+        else if (suffix == "M" || suffix == "m") scale = 1024.0 * 1024.0;
+        else if (suffix == "G" || suffix == "g") scale = 1024.0 * 1024.0 * 1024.0;
+        else if (!suffix.empty()) return false;
+        if (value <= 0) return false;
+        bytes = static_cast<size_t>(value * scale);
+        return bytes > 0;
+    } catch (...) {
+        return false;
+    }
+}
+
+SpillStore::SpillStore(const std::string& path, long origin, int stepsPerDay, size_t nTime, size_t stationBlock, size_t timeBlock)
+    : m_path(path), m_origin(origin), m_stepsPerDay(stepsPerDay), m_nTime(nTime),
+      m_stationBlock(std::max<size_t>(1, stationBlock)), m_timeBlock(std::max<size_t>(1, timeBlock)) {
+    m_timeBlocks = (m_nTime + m_timeBlock - 1) / m_timeBlock;
+#ifdef SWAT2NETCDF_MMAP_SPILL
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (m_fd < 0) {
+        std::cerr << "Warning: Could not create scratch file " << path << ". Keeping station data in memory." << std::endl;
+    } else {
+        // Unlinked right away: the space is released when the store closes, even after a crash
+        unlink(path.c_str());
+    }
+#endif
+}
+
+SpillStore::~SpillStore() {
+#ifdef SWAT2NETCDF_MMAP_SPILL
+    for (auto& region : m_vars) {
+        if (m_fd >= 0 && region.data) munmap(region.data, region.bytes);
+    }
+    if (m_fd >= 0) close(m_fd);
+#endif
+}
+
+bool SpillStore::addVariable(VariableId id, size_t slots) {
+    remove(id);
+    Region region;
+    region.slots = slots;
+    region.stationBlocks = (slots + m_stationBlock - 1) / m_stationBlock;
+    region.bytes = std::max<size_t>(1, m_timeBlocks * region.stationBlocks * m_timeBlock * m_stationBlock) * sizeof(float);
+    region.min = std::numeric_limits<double>::max();
+    region.max = std::numeric_limits<double>::lowest();
+
+#ifdef SWAT2NETCDF_MMAP_SPILL
+    if (m_fd >= 0) {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        region.offset = (m_fileSize + page - 1) / page * page;
+        if (ftruncate(m_fd, static_cast<off_t>(region.offset + region.bytes)) != 0) {
+            std::cerr << "Error: Could not grow scratch file " << m_path << std::endl;
+            return false;
+        }
+        void* mapped = mmap(nullptr, region.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, static_cast<off_t>(region.offset));
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Error: Could not map scratch file " << m_path << std::endl;
+            return false;
+        }
+        region.data = static_cast<float*>(mapped);
+        m_fileSize = region.offset + region.bytes;
+        m_vars[static_cast<size_t>(id)] = region;
+        return true;
+    }
+#endif
+    m_heap.emplace_back(region.bytes / sizeof(float));
+    region.data = m_heap.back().data();
+    m_vars[static_cast<size_t>(id)] = region;
+    return true;
+}
+
+void SpillStore::remove(VariableId id) {
+    Region& region = m_vars[static_cast<size_t>(id)];
+#ifdef SWAT2NETCDF_MMAP_SPILL
+    if (m_fd >= 0 && region.data) munmap(region.data, region.bytes);
+#endif
+    region = Region();
+}
+
+float* SpillStore::tile(const Region& region, size_t timeBlock, size_t stationBlock) const {
+    return region.data + (timeBlock * region.stationBlocks + stationBlock) * m_timeBlock * m_stationBlock;
+}
+
+void SpillStore::write(VariableId id, size_t firstSlot, const std::vector<Station>& stations, size_t first, size_t count) {
+    Region& region = m_vars[static_cast<size_t>(id)];
+    const float missing = Converter::kMissingValue;
+
+    std::vector<long> offsets(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Station& st = stations[first + i];
+        offsets[i] = st.startYear == -1 ? 0 : (Utils::dayIndex(st.startYear, st.startDay) - m_origin) * m_stepsPerDay + st.startStep;
+    }
+
+    // One station block at a time; inside a tile each time row is written contiguously across stations
+    size_t slot = firstSlot, end = firstSlot + count;
+    while (slot < end) {
+        size_t block = slot / m_stationBlock;
+        size_t blockEnd = std::min(end, (block + 1) * m_stationBlock);
+        for (size_t tb = 0; tb < m_timeBlocks; ++tb) {
+            float* base = tile(region, tb, block);
+            size_t rows = std::min(m_timeBlock, m_nTime - tb * m_timeBlock);
+            for (size_t r = 0; r < rows; ++r) {
+                long t = static_cast<long>(tb * m_timeBlock + r);
+                float* row = base + r * m_stationBlock;
+                for (size_t s = slot; s < blockEnd; ++s) {
+                    const Station& st = stations[first + (s - firstSlot)];
+                    long local = t - offsets[s - firstSlot];
+                    bool present = st.startYear != -1 && local >= 0 && local < static_cast<long>(st.data.size());
+                    float value = present ? static_cast<float>(st.data[local]) : missing;
+                    row[s % m_stationBlock] = value;
+                    if (value != missing) {
+                        region.min = std::min(region.min, static_cast<double>(value));
+                        region.max = std::max(region.max, static_cast<double>(value));
+                    }
+                }
+            }
+        }
+        slot = blockEnd;
+    }
+}
+
+void SpillStore::fill(VariableId id, size_t fromSlot) {
+    Region& region = m_vars[static_cast<size_t>(id)];
+    for (size_t slot = fromSlot; slot < region.stationBlocks * m_stationBlock; ++slot) {
+        size_t block = slot / m_stationBlock;
+        for (size_t tb = 0; tb < m_timeBlocks; ++tb) {
+            float* base = tile(region, tb, block);
+            for (size_t r = 0; r < m_timeBlock; ++r) base[r * m_stationBlock + slot % m_stationBlock] = Converter::kMissingValue;
+        }
+    }
+}
+
+void SpillStore::read(VariableId id, size_t timeStart, size_t timeCount, float* out) const {
+    const Region& region = m_vars[static_cast<size_t>(id)];
+    for (size_t i = 0; i < timeCount; ++i) {
+        size_t t = timeStart + i;
+        size_t tb = t / m_timeBlock, r = t % m_timeBlock;
+        float* dest = out + i * region.slots;
+        for (size_t block = 0; block < region.stationBlocks; ++block) {
+            size_t n = std::min(m_stationBlock, region.slots - block * m_stationBlock);
+            std::memcpy(dest + block * m_stationBlock, tile(region, tb, block) + r * m_stationBlock, n * sizeof(float));
+        }
+    }
+}
+
+std::vector<double> SpillStore::series(VariableId id, size_t slot) const {
+    const Region& region = m_vars[static_cast<size_t>(id)];
+    size_t block = slot / m_stationBlock, column = slot % m_stationBlock;
+    std::vector<double> out(m_nTime);
+    for (size_t t = 0; t < m_nTime; ++t) {
+        out[t] = tile(region, t / m_timeBlock, block)[(t % m_timeBlock) * m_stationBlock + column];
+    }
+    return out;
+}
+
+bool SpillStore::bounds(VariableId id, double& min, double& max) const {
+    const Region& region = m_vars[static_cast<size_t>(id)];
+    if (region.min > region.max) return false;
+    min = region.min;
+    max = region.max;
+    return true;
+}
@@ -0,0 +1,383 @@
+#include "Tiling.h"
+#include "Converter.h"
+#include "Utils.h"
+#include <algorithm>
+#include <map>
+#include <iostream>
+#include <memory>
+#include <netcdf>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+using namespace netCDF;
+
+namespace {
+
+// Largest chunk edge (in cells) along lat/lon, and target chunk and copy sizes
+const int kMaxChunkEdge = 256;
+const size_t kChunkBytes = 4 * 1024 * 1024;
+const size_t kCopyBlockBytes = 64 * 1024 * 1024;
+
+bool parsePositive(const std::string& text, int& value) {
+    try {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        return used == text.size() && value > 0;
+    } catch (...) {
+        return false;
+    }
+}
+
+// Cells per tile along one axis, rounded up to a whole number of chunks
+void splitAxis(int cells, int parts, int& step, int& chunk) {
+    int base = (cells + parts - 1) / parts;
+    int pieces = (base + kMaxChunkEdge - 1) / kMaxChunkEdge;
+    chunk = (base + pieces - 1) / pieces;
+    step = chunk * pieces;
+}
+
+template <class Att, class Target>
+void copyAttribute(const std::string& name, const Att& att, const Target& target) {
+    NcType type = att.getType();
+    if (type == ncChar) {
+        std::string text;
+        att.getValues(text);
+        target.putAtt(name, text);
+    } else {
+        std::vector<char> values(att.getAttLength() * type.getSize());
+        att.getValues(values.data());
+        target.putAtt(name, type, att.getAttLength(), values.data());
+    }
+}
+
+void copyAttributes(const NcVar& source, const NcVar& target) {
+    for (const auto& entry : source.getAtts()) copyAttribute(entry.first, entry.second, target);
+}
+
+int intAttribute(const NcFile& file, const std::string& name) {
+    int value = 0;
+    file.getAtt(name).getValues(&value);
+    return value;
+}
+
+std::map<std::string, NcType> dataVariables(const NcFile& file) {
+    std::map<std::string, NcType> types;
+    for (const auto& entry : file.getVars()) {
+        if (entry.first != "lat" && entry.first != "lon" && entry.first != "time") types.emplace(entry.first, entry.second.getType());
+    }
+    return types;
+}
+
+// Why tile `index` (0-based) of `count` cannot be merged into the grid of `first`; empty if it can.
+// Catches tile files left over from an earlier run with another layout, grid, period or variable set.
+std::string tileMismatch(const NcFile& first, const NcFile& tile, int index, int count) {
+    int tileCount = intAttribute(tile, "tile_count");
+    if (tileCount != count) return "it is one of " + std::to_string(tileCount) + " tiles, not " + std::to_string(count);
+    int tileIndex = intAttribute(tile, "tile_index");
+    if (tileIndex != index) return "it holds tile " + std::to_string(tileIndex + 1) + ", not " + std::to_string(index + 1);
+
+    int nLat = intAttribute(first, "grid_nlat"), nLon = intAttribute(first, "grid_nlon");
+    int tileLat = intAttribute(tile, "grid_nlat"), tileLon = intAttribute(tile, "grid_nlon");
+    if (tileLat != nLat || tileLon != nLon) {
+        return "its grid is " + std::to_string(tileLat) + "x" + std::to_string(tileLon) + ", not " +
+               std::to_string(nLat) + "x" + std::to_string(nLon);
+    }
+
+    size_t nTime = first.getDim("time").getSize();
+    size_t tileTime = tile.getDim("time").getSize();
+    if (tileTime != nTime) return "it has " + std::to_string(tileTime) + " time steps, not " + std::to_string(nTime);
+    std::string units, tileUnits;
+    first.getVar("time").getAtt("units").getValues(units);
+    tile.getVar("time").getAtt("units").getValues(tileUnits);
+    std::vector<double> times(nTime), tileTimes(nTime);
+    first.getVar("time").getVar(times.data());
+    tile.getVar("time").getVar(tileTimes.data());
+    if (tileUnits != units || tileTimes != times) return "its time axis differs";
+
+    std::map<std::string, NcType> variables = dataVariables(first);
+    std::map<std::string, NcType> tileVariables = dataVariables(tile);
+    bool sameVariables = variables.size() == tileVariables.size();
+    for (const auto& entry : variables) {
+        auto match = tileVariables.find(entry.first);
+        sameVariables = sameVariables && match != tileVariables.end() && match->second == entry.second;
+    }
+    if (!sameVariables) {
+        std::string names;
+        for (const auto& entry : tileVariables) names += (names.empty() ? "" : ", ") + entry.first;
+        return "its variables (" + names + ") or their types differ";
+    }
+    return "";
+}
+
+}
+
+bool parseTileLayout(const std::string& text, TileSpec& spec) {
+    size_t x = text.find_first_of("xX");
+    int rows = 0, cols = 0;
+    if (x == std::string::npos || !parsePositive(text.substr(0, x), rows) || !parsePositive(text.substr(x + 1), cols)) {
+        return false;
+    }
+    spec.rows = rows;
+    spec.cols = cols;
+    return true;
+}
+
+bool parseTileIndex(const std::string& text, TileSpec& spec) {
+    size_t slash = text.find('/');
+    int index = 0, count = 0;
+    if (slash == std::string::npos || !parsePositive(text.substr(0, slash), index) ||
+        !parsePositive(text.substr(slash + 1), count) || index > count) {
+        return false;
+    }
+
+    if (spec.count() != count) {
+        // Squarest layout: the largest divisor of count not above its square root
+        int rows = 1;
+        for (int r = 1; r * r <= count; ++r) {
+            if (count % r == 0) rows = r;
+        }
+        spec.rows = rows;
+        spec.cols = count / rows;
+    }
+    spec.index = index - 1;
+    return true;
+}
+
+std::vector<Tile> gridTiles(const GridSpec& grid, const TileSpec& spec) {
+    std::vector<Tile> tiles;
+    if (spec.rows > grid.nLat || spec.cols > grid.nLon) return tiles;
+
+    int latStep, lonStep, chunkLat, chunkLon;
+    splitAxis(grid.nLat, spec.rows, latStep, chunkLat);
+    splitAxis(grid.nLon, spec.cols, lonStep, chunkLon);
+
+    for (int r = 0; r < spec.rows; ++r) {
+        for (int c = 0; c < spec.cols; ++c) {
+            Tile tile;
+            tile.index = r * spec.cols + c;
+            tile.latStart = r * latStep;
+            tile.lonStart = c * lonStep;
+            tile.latCount = std::min(grid.nLat, tile.latStart + latStep) - tile.latStart;
+            tile.lonCount = std::min(grid.nLon, tile.lonStart + lonStep) - tile.lonStart;
+            tile.chunkLat = chunkLat;
+            tile.chunkLon = chunkLon;
+            // Rounding tiles up to whole chunks can leave the last row or column empty
+            if (tile.latCount <= 0 || tile.lonCount <= 0) return {};
+            tiles.push_back(tile);
+        }
+    }
+    return tiles;
+}
+
+GridSpec tileGrid(const GridSpec& grid, const Tile& tile) {
+    GridSpec local = grid;
+    local.minLat = grid.minLat + tile.latStart * grid.resolution;
+    local.minLon = grid.minLon + tile.lonStart * grid.resolution;
+    local.maxLat = local.minLat + (tile.latCount - 1) * grid.resolution;
+    local.maxLon = local.minLon + (tile.lonCount - 1) * grid.resolution;
+    local.nLat = tile.latCount;
+    local.nLon = tile.lonCount;
+    return local;
+}
+
+std::vector<size_t> tileChunking(const Tile& tile, size_t nTime) {
+    size_t plane = static_cast<size_t>(tile.chunkLat) * tile.chunkLon * sizeof(float);
+    size_t steps = std::max<size_t>(1, std::min(nTime, kChunkBytes / plane));
+    return {steps, static_cast<size_t>(tile.chunkLat), static_cast<size_t>(tile.chunkLon)};
+}
+
+std::string tileFileName(const std::string& region, int index, int count) {
+    return region + "_tile" + std::to_string(index + 1) + "of" + std::to_string(count) + ".nc4";
+}
+
+namespace Tiling {
+
+    bool runProcesses(const std::vector<std::string>& args, int count, size_t jobs, const std::string& logPrefix) {
+#if defined(__unix__) || defined(__APPLE__)
+        // Prefer the running binary itself; argv[0] may be relative to a directory we are not in
+        std::string exe = access("/proc/self/exe", X_OK) == 0 ? "/proc/self/exe" : args[0];
+        jobs = std::max<size_t>(1, jobs);
+
+        std::vector<pid_t> running;
+        std::vector<int> tileOf;
+        bool ok = true;
+        int next = 0, finished = 0;
+
+        auto reap = [&]() {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if (pid <= 0) return;
+            auto it = std::find(running.begin(), running.end(), pid);
+            if (it == running.end()) return;
+            int tile = tileOf[it - running.begin()];
+            tileOf.erase(tileOf.begin() + (it - running.begin()));
+            running.erase(it);
+
+            bool tileOk = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            if (!tileOk) {
+                std::cerr << "\nTile " << tile + 1 << "/" << count << " failed; see "
+                          << logPrefix << tile + 1 << "of" << count << ".log" << std::endl;
+                ok = false;
+            }
+            ++finished;
+            Utils::dualProgress(finished, count, finished, count, 40,
+                                (tileOk ? "Tile " : "Failed tile ") + std::to_string(tile + 1));
+        };
+
+        while (next < count || !running.empty()) {
+            if (next < count && running.size() < jobs) {
+                std::vector<std::string> childArgs = args;
+                childArgs.push_back("--tile");
+                childArgs.push_back(std::to_string(next + 1) + "/" + std::to_string(count));
+                std::vector<char*> argv;
+                for (auto& a : childArgs) argv.push_back(&a[0]);
+                argv.push_back(nullptr);
+
+                std::string logPath = logPrefix + std::to_string(next + 1) + "of" + std::to_string(count) + ".log";
+                posix_spawn_file_actions_t actions;
+                posix_spawn_file_actions_init(&actions);
+                posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+                pid_t pid;
+                int rc = posix_spawn(&pid, exe.c_str(), &actions, nullptr, argv.data(), environ);
+                posix_spawn_file_actions_destroy(&actions);
+                if (rc != 0) {
+                    std::cerr << "Error: Could not start process for tile " << next + 1 << std::endl;
+                    ok = false;
+                    break;
+                }
+                running.push_back(pid);
+                tileOf.push_back(next);
+                ++next;
+            } else {
+                reap();
+            }
+        }
+        while (!running.empty()) reap();
+        std::cout << std::endl;
+        return ok;
+#else
+        (void)args; (void)count; (void)jobs; (void)logPrefix;
+        std::cerr << "Error: Running tiles as local processes is not supported on this platform. "
+                  << "Convert each tile with --tile i/N and merge with --mergeTiles N." << std::endl;
+        return false;
+#endif
+    }
+
+    std::vector<std::pair<std::string, std::string>> merge(const std::vector<std::string>& tileFiles, const std::string& output) {
+        std::vector<std::pair<std::string, std::string>> variables;
+        try {
+            std::vector<std::unique_ptr<NcFile>> tiles;
+            for (const auto& path : tileFiles) tiles.push_back(std::make_unique<NcFile>(path, NcFile::read));
+            if (tiles.empty()) return variables;
+
+            const NcFile& first = *tiles[0];
+            const int count = static_cast<int>(tiles.size());
+            for (int k = 0; k < count; ++k) {
+                std::string reason;
+                try {
+                    reason = tileMismatch(first, *tiles[k], k, count);
+                } catch (std::exception& e) {
+                    reason = e.what();
+                }
+                if (!reason.empty()) {
+                    std::cerr << "Error: Tile file " << tileFiles[k] << " does not match " << tileFiles[0] << ": " << reason
+                              << ". Remove stale tile files and convert the tiles again." << std::endl;
+                    return {};
+                }
+            }
+
+            const int nLat = intAttribute(first, "grid_nlat");
+            const int nLon = intAttribute(first, "grid_nlon");
+            const size_t nTime = first.getDim("time").getSize();
+
+            NcFile merged(output, NcFile::replace);
+            NcDim timeDim = merged.addDim("time", nTime);
+            NcDim latDim = merged.addDim("lat", nLat);
+            NcDim lonDim = merged.addDim("lon", nLon);
+
+            NcVar latVar = merged.addVar("lat", ncDouble, latDim);
+            NcVar lonVar = merged.addVar("lon", ncDouble, lonDim);
+            NcVar timeVar = merged.addVar("time", ncDouble, timeDim);
+            copyAttributes(first.getVar("lat"), latVar);
+            copyAttributes(first.getVar("lon"), lonVar);
+            copyAttributes(first.getVar("time"), timeVar);
+
+            // Coordinates are assembled from the tiles; time is shared
+            std::vector<double> lats(nLat), lons(nLon), times(nTime);
+            std::vector<int> latStart, lonStart, latCount, lonCount;
+            for (const auto& tile : tiles) {
+                latStart.push_back(intAttribute(*tile, "tile_lat_start"));
+                lonStart.push_back(intAttribute(*tile, "tile_lon_start"));
+                latCount.push_back(static_cast<int>(tile->getDim("lat").getSize()));
+                lonCount.push_back(static_cast<int>(tile->getDim("lon").getSize()));
+                if (latStart.back() + latCount.back() > nLat || lonStart.back() + lonCount.back() > nLon) {
+                    std::cerr << "Error: Tile extent outside the " << nLat << "x" << nLon << " grid." << std::endl;
+                    return {};
+                }
+                tile->getVar("lat").getVar(lats.data() + latStart.back());
+                tile->getVar("lon").getVar(lons.data() + lonStart.back());
+            }
+            first.getVar("time").getVar(times.data());
+            latVar.putVar(lats.data());
+            lonVar.putVar(lons.data());
+            timeVar.putVar(times.data());
+
+            // Data variables in definition order
+            std::vector<NcVar> dataVars;
+            for (const auto& entry : first.getVars()) {
+                if (entry.first != "lat" && entry.first != "lon" && entry.first != "time") dataVars.push_back(entry.second);
+            }
+            std::sort(dataVars.begin(), dataVars.end(), [](const NcVar& a, const NcVar& b) { return a.getId() < b.getId(); });
+
+            for (const auto& source : dataVars) {
+                const std::string name = source.getName();
+                NcType type = source.getType();
+                NcVar target = merged.addVar(name, type, {timeDim, latDim, lonDim});
+                copyAttributes(source, target);
+
+                NcVar::ChunkMode mode;
+                std::vector<size_t> chunks;
+                source.getChunkingParameters(mode, chunks);
+                if (mode == NcVar::nc_CHUNKED && chunks.size() == 3) target.setChunking(mode, chunks);
+                size_t timeChunk = chunks.size() == 3 ? std::max<size_t>(1, chunks[0]) : 1;
+
+                std::string unit;
+                source.getAtt("units").getValues(unit);
+                variables.push_back({name, unit});
+
+                // Tile edges sit on chunk boundaries and blocks span whole time chunks,
+                // so every write covers complete chunks of the merged variable
+                std::vector<char> buffer;
+                for (size_t k = 0; k < tiles.size(); ++k) {
+                    NcVar tileVar = tiles[k]->getVar(name);
+                    size_t plane = static_cast<size_t>(latCount[k]) * lonCount[k] * type.getSize();
+                    size_t blockSteps = std::max<size_t>(1, kCopyBlockBytes / plane);
+                    blockSteps = std::min(nTime, std::max(timeChunk, blockSteps / timeChunk * timeChunk));
+                    buffer.resize(blockSteps * plane);
+
+                    for (size_t t = 0; t < nTime; t += blockSteps) {
+                        size_t steps = std::min(blockSteps, nTime - t);
+                        std::vector<size_t> count = {steps, static_cast<size_t>(latCount[k]), static_cast<size_t>(lonCount[k])};
+                        tileVar.getVar({t, 0, 0}, count, buffer.data());
+                        target.putVar({t, static_cast<size_t>(latStart[k]), static_cast<size_t>(lonStart[k])}, count, buffer.data());
+                    }
+                }
+                Utils::dualProgress(static_cast<int>(variables.size()), static_cast<int>(dataVars.size()),
+                                    static_cast<int>(variables.size()), static_cast<int>(dataVars.size()), 40, "Merged " + name);
+            }
+            std::cout << std::endl;
+            return variables;
+
+        } catch (std::exception& e) {
+            std::cerr << "Error merging tiles into " << output << ": " << e.what() << std::endl;
+        }
+        return {};
+    }
+}
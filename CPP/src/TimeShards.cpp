@@ -0,0 +1,79 @@
+#include "TimeShards.h"
+#include "Converter.h"
+#include "Utils.h"
+#include <fstream>
+
+bool parseShardSpec(const std::string& text, ShardSpec& spec) {
+    if (text == "year") {
+        spec.mode = ShardSpec::Year;
+    } else if (text == "decade") {
+        spec.mode = ShardSpec::Decade;
+    } else {
+        try {
+            size_t used = 0;
+            int days = std::stoi(text, &used);
+            if (used != text.size() || days <= 0) return false;
+            spec.mode = ShardSpec::Days;
+            spec.days = days;
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<TimeShard> timeShards(const GridSpec& grid, const ShardSpec& spec) {
+    std::vector<TimeShard> shards;
+    if (grid.startYear == -1 || grid.nTime == 0) return shards;
+
+    if (spec.mode == ShardSpec::None) {
+        shards.push_back({"", 0, grid.nTime});
+        return shards;
+    }
+
+    // Shard edges fall on day boundaries, counted in grid steps
+    const long origin = Utils::dayIndex(grid.startYear, grid.startDay);
+    const size_t steps = static_cast<size_t>(grid.stepsPerDay);
+    size_t t = 0;
+    int year = grid.startYear;
+
+    while (t < grid.nTime) {
+        size_t end;
+        std::string label;
+        if (spec.mode == ShardSpec::Year) {
+            end = static_cast<size_t>(Utils::dayIndex(year + 1, 1) - origin) * steps;
+            label = std::to_string(year);
+            year += 1;
+        } else if (spec.mode == ShardSpec::Decade) {
+            int decade = year - ((year % 10) + 10) % 10;
+            end = static_cast<size_t>(Utils::dayIndex(decade + 10, 1) - origin) * steps;
+            label = std::to_string(decade) + "s";
+            year = decade + 10;
+        } else {
+            end = t + static_cast<size_t>(spec.days) * steps;
+        }
+        end = std::min(end, grid.nTime);
+
+        if (spec.mode == ShardSpec::Days) {
+            label = Utils::formatDate(origin + static_cast<long>(t / steps)) + "_" + Utils::formatDate(origin + static_cast<long>((end - 1) / steps));
+        }
+        shards.push_back({label, t, end - t});
+        t = end;
+    }
+    return shards;
+}
+
+bool writeShardIndex(const std::string& path, const std::vector<TimeShard>& shards, const std::vector<std::string>& files) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<netcdf xmlns=\"http://www.unidata.ucar.edu/namespaces/netcdf/ncml-2.2\">\n";
+    out << "  <aggregation dimName=\"time\" type=\"joinExisting\">\n";
+    for (size_t i = 0; i < shards.size() && i < files.size(); ++i) {
+        out << "    <netcdf location=\"" << files[i] << "\" ncoords=\"" << shards[i].timeCount << "\"/>\n";
+    }
+    out << "  </aggregation>\n";
+    out << "</netcdf>\n";
+    return out.good();
+}
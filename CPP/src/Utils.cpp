@@ -1,4 +1,5 @@
 #include "Utils.h"
+#include "Variables.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -6,10 +7,25 @@
 #include <algorithm>
 #include <iomanip>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define SWAT2NETCDF_MKSTEMP
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <cstdio>
+#include <random>
+#endif
+
 namespace fs = std::filesystem;
 
 namespace Utils {
 
+    namespace {
+        bool isWeatherGroup(const std::string& group) {
+            return Variables::findGroup(group) != nullptr;
+        }
+    }
+
     bool copyFile(const std::string& src, const std::string& dst) {
         try {
             fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
@@ -56,13 +72,57 @@ namespace Utils {
     }
 
     bool writeFile(const std::string& path, const std::string& content) {
-        std::ofstream out(path);
+        std::ofstream out(path, std::ios::binary);
         out << content;
         return out.good();
     }
 
-    void updateFileCIO(const std::string& txtInOutDir, const std::string& convertedDir, const std::string& regionName) {
-        std::string content = readFile(txtInOutDir + "/file.cio");
+    std::string temporaryFile(const std::string& path) {
+#ifdef SWAT2NETCDF_MKSTEMP
+        std::string name = path + ".XXXXXX";
+        int fd = mkstemp(&name[0]);
+        if (fd < 0) return "";
+        // mkstemp creates the file 0600; the renamed output gets the permissions a plain create would give it
+        static const mode_t mask = [] { mode_t m = umask(0); umask(m); return m; }();
+        fchmod(fd, 0666 & ~mask);
+        close(fd);
+        return name;
+#else
+        static const char kChars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        std::random_device random;
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            std::string name = path + ".";
+            for (int i = 0; i < 6; ++i) name += kChars[random() % (sizeof(kChars) - 1)];
+            if (std::FILE* file = std::fopen(name.c_str(), "wbx")) {
+                std::fclose(file);
+                return name;
+            }
+        }
+        return "";
+#endif
+    }
+
+    bool isModelInputFile(const std::string& filename) {
+        if (filename == "weather-wgn.cli") return true;
+
+        // Station files and their index are replaced by the NetCDF file and netcdf.ncw
+        if (filename == "weather-sta.cli") return false;
+        const std::vector<std::string> skipped = {".txt", ".cli", ".tmp", ".wnd", ".slr", ".hmd", ".pcp", ".tem"};
+        for (const auto& ext : skipped) {
+            if (filename.length() >= ext.length() && filename.compare(filename.length() - ext.length(), ext.length(), ext) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void updateFileCIO(const std::string& txtInOutDir, const std::string& convertedDir, const std::string& regionName,
+                       const std::vector<std::string>& variables) {
+        writeFileCIO(readFile(txtInOutDir + "/file.cio"), convertedDir, regionName, variables);
+    }
+
+    void writeFileCIO(const std::string& content, const std::string& convertedDir, const std::string& regionName,
+                      const std::vector<std::string>& variables) {
         std::stringstream ss(content);
         std::string line;
         std::stringstream output;
@@ -80,18 +140,11 @@ namespace Utils {
             std::string trimmed = line;
             trimmed.erase(0, trimmed.find_first_not_of(" \t\r\n"));
             
-            if (trimmed.find("pcp_path") == 0) {
-                 output << "pcp_path          " << regionName << ".nc4   \n";
-            } else if (trimmed.find("tmp_path") == 0) {
-                 output << "tmp_path          " << regionName << ".nc4   \n";
-            } else if (trimmed.find("slr_path") == 0) {
-                 output << "slr_path          " << regionName << ".nc4   \n";
-            } else if (trimmed.find("hmd_path") == 0) {
-                 output << "hmd_path          " << regionName << ".nc4   \n";
-            } else if (trimmed.find("wnd_path") == 0) {
-                 output << "wnd_path          " << regionName << ".nc4   \n";
-            } else if (trimmed.find("pet_path") == 0) {
-                 output << "pet_path          " << regionName << ".nc4   \n";
+            std::string group = trimmed.substr(0, 3);
+            if (trimmed.size() >= 8 && trimmed.compare(3, 5, "_path") == 0 && isWeatherGroup(group)) {
+                 // Unselected groups fall back to the weather generator, matching their null column in netcdf.ncw
+                 bool selected = variables.empty() || std::find(variables.begin(), variables.end(), group) != variables.end();
+                 output << group << "_path          " << (selected ? regionName + ".nc4" : std::string("null")) << "   \n";
             } else if (trimmed.find("climate") == 0) {
                  // Python: climate           netcdf.ncw        weather-wgn.cli   null              null              null              null              null              null              null
                  output << "climate           netcdf.ncw        weather-wgn.cli   null              null              null              null              null              null              null\n";
@@ -104,6 +157,89 @@ namespace Utils {
         writeFile(convertedDir + "/file.cio", output.str());
     }
 
+    std::vector<std::string> climateVariables(const std::string& txtInOutDir) {
+        return parseClimateVariables(readFile(txtInOutDir + "/file.cio"));
+    }
+
+    std::vector<std::string> parseClimateVariables(const std::string& content) {
+        std::stringstream ss(content);
+        std::string line;
+        while (std::getline(ss, line)) {
+            std::stringstream fields(line);
+            std::string keyword, station, wgn;
+            if (!(fields >> keyword) || keyword != "climate") continue;
+            if (!(fields >> station >> wgn) || station == "netcdf.ncw") return {};
+
+            // Entries follow the registry's climate column order
+            const char* columns[Variables::kGroupCount];
+            for (const auto& g : Variables::kGroups) columns[g.climateColumn] = g.name;
+
+            std::vector<std::string> groups;
+            std::string entry;
+            for (const char* group : columns) {
+                if (!(fields >> entry)) break;
+                if (entry != "null") groups.push_back(group);
+            }
+            return groups;
+        }
+        return {};
+    }
+
+    bool parseVariableList(const std::string& text, std::vector<std::string>& groups) {
+        groups.clear();
+        std::stringstream ss(text);
+        std::string group;
+        while (std::getline(ss, group, ',')) {
+            if (group.empty()) continue;
+            if (!isWeatherGroup(group)) return false;
+            if (std::find(groups.begin(), groups.end(), group) == groups.end()) groups.push_back(group);
+        }
+        return !groups.empty();
+    }
+
+    long dayIndex(int year, int dayOfYear) {
+        // Days from civil (proleptic Gregorian) for January 1st, then add the day of year
+        long y = year - 1;
+        long era = (y >= 0 ? y : y - 399) / 400;
+        long yoe = y - era * 400;
+        long doy = 306; // March 1st to January 1st of the following year
+        long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468 + (dayOfYear - 1);
+    }
+
+    std::string formatDate(long dayIndex) {
+        long z = dayIndex + 719468;
+        long era = (z >= 0 ? z : z - 146096) / 146097;
+        long doe = z - era * 146097;
+        long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long mp = (5 * doy + 2) / 153;
+        long day = doy - (153 * mp + 2) / 5 + 1;
+        long month = mp < 10 ? mp + 3 : mp - 9;
+        long year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+        std::stringstream ss;
+        ss << year << "-" << std::setw(2) << std::setfill('0') << month
+           << "-" << std::setw(2) << std::setfill('0') << day;
+        return ss.str();
+    }
+
+    bool parseDate(const std::string& text, long& dayIndex) {
+        int year, month, day;
+        char dash1, dash2;
+        std::stringstream ss(text);
+        if (!(ss >> year >> dash1 >> month >> dash2 >> day) || dash1 != '-' || dash2 != '-') return false;
+
+        static const int kMonthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        if (month < 1 || month > 12 || day < 1 || day > kMonthDays[month - 1] + (leap && month == 2 ? 1 : 0)) return false;
+
+        int dayOfYear = day;
+        for (int m = 1; m < month; ++m) dayOfYear += kMonthDays[m - 1] + (leap && m == 2 ? 1 : 0);
+        dayIndex = Utils::dayIndex(year, dayOfYear);
+        return true;
+    }
+
     void dualProgress(int primaryCount, int primaryEnd, int secondaryCount, int secondaryEnd, int barLength, const std::string& message) {
         std::string darkBlock   = "█";
         std::string denseBlock  = "▒";
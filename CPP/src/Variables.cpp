@@ -0,0 +1,18 @@
+#include "Variables.h"
+
+namespace Variables {
+
+    const GroupDescriptor* findGroup(const std::string& name) {
+        for (const auto& g : kGroups) {
+            if (name == g.name) return &g;
+        }
+        return nullptr;
+    }
+
+    const VariableDescriptor* findVariable(const std::string& name) {
+        for (const auto& v : kVariables) {
+            if (name == v.name) return &v;
+        }
+        return nullptr;
+    }
+}
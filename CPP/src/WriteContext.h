@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Converter.h"
+#include "Interpolator.h"
+#include "Packing.h"
+
+// Internal to the library: what prepareWrite() computes once per grid and every writer shares
+struct Converter::WriteContext {
+    std::map<VariableId, std::shared_ptr<const StationInterpolator>> interpolators; // shared per station set
+    size_t tableBytes = 0;                                 // memory held by the distinct interpolators
+    std::map<VariableId, PackParams> packing;
+    std::vector<size_t> chunking;                          // {time, lat, lon}; empty = library default
+    std::vector<std::pair<std::string, int>> attributes;   // global int attributes
+    std::vector<VariableId> variables;                     // variables written; empty = every loaded variable
+    size_t threads = 0;                                    // interpolation threads per block; 0 = one per core
+};
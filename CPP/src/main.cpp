@@ -1,10 +1,17 @@
 #include "Converter.h"
+#include "Archive.h"
+#include "Server.h"
+#include "SpillStore.h"
+#include "Tiling.h"
 #include "Utils.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <filesystem>
+#include <sstream>
+#include <cctype>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -19,6 +26,12 @@ char* getCmdOption(char ** begin, char ** end, const std::string & option)
     return 0;
 }
 
+// Negative numbers (e.g. "-99,-999") are option values, not option names
+bool isOptionName(const char* arg)
+{
+    return arg[0] == '-' && !(std::isdigit(static_cast<unsigned char>(arg[1])) || arg[1] == '.');
+}
+
 bool cmdOptionExists(char** begin, char** end, const std::string& option)
 {
     return std::find(begin, end, option) != end;
@@ -28,11 +41,28 @@ void printUsage() {
     std::cout << "Usage: swat_nc_converter -r <RegionName> -i <InputPath> -o <OutputPath> [options]" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  -r,   --region <name>            Region name (required)" << std::endl;
-    std::cout << "  -i,   --inputPath <path>         Input TxtInOut directory (required)" << std::endl;
+    std::cout << "  -i,   --inputPath <path>         Input TxtInOut directory or .zip/.tar.gz archive (required)" << std::endl;
     std::cout << "  -o,   --outputPath <path>        Output converted directory (required)" << std::endl;
     std::cout << "  -res, --climateResolution <float> Resolution in degrees (default: 0.25)" << std::endl;
     std::cout << "  -b,   --shapePath <path>         Path to shapefile" << std::endl;
     std::cout << "  -s,   --stopDate <YYYY-MM-DD>    Stop date (default: 2500-12-31)" << std::endl;
+    std::cout << "  -ip,  --interp <mode>            Gridding: none, nearest or idw (default: none)" << std::endl;
+    std::cout << "  -qa,  --qa <action>              Run QA: flag, clip or mask out-of-range values" << std::endl;
+    std::cout << "  -mv,  --missingValues <list>     Input sentinels mapped to -9999 during QA (default: -99,-999)" << std::endl;
+    std::cout << "  -pet, --derivePet <method>       Compute PET: hargreaves or priestley-taylor" << std::endl;
+    std::cout << "  -var, --variables <list>         Weather groups to convert, e.g. pcp,tmp (default: file.cio climate line)" << std::endl;
+    std::cout << "  -io,  --ioBackend <backend>      Station file reads: auto, uring or posix (default: auto)" << std::endl;
+    std::cout << "  -sh,  --shardBy <spec>           Split output in time: year, decade or N days" << std::endl;
+    std::cout << "  -os,  --onlyShards <labels>      Rewrite only these shards (comma-separated labels)" << std::endl;
+    std::cout << "  -pk,  --pack                     Store variables as int16 with scale_factor/add_offset" << std::endl;
+    std::cout << "  -mm,  --maxMemory <size>         Budget for station series, e.g. 8G; larger inputs spill to disk" << std::endl;
+    std::cout << "  -ts,  --tiles <RxC>              Split the grid into RxC tiles converted by parallel processes" << std::endl;
+    std::cout << "  -tl,  --tile <i/N>               Convert only tile i of N (e.g. one batch job per tile)" << std::endl;
+    std::cout << "  -tj,  --tileJobs <n>             Tile processes run at once (default: number of cores)" << std::endl;
+    std::cout << "  -mt,  --mergeTiles <N>           Merge the N tile files into <region>.nc4" << std::endl;
+    std::cout << "  -sv,  --serve                    Load the stations once and answer JSON requests on a Unix socket" << std::endl;
+    std::cout << "  -sk,  --socket <path>            Socket for --serve (default: <outputPath>/<region>.sock)" << std::endl;
+    std::cout << "  -sw,  --workers <n>              Requests --serve handles at once (default: number of cores)" << std::endl;
     std::cout << "  -h,   --help                     Show this help message" << std::endl;
 }
 
@@ -46,12 +76,17 @@ int main(int argc, char * argv[]) {
     std::vector<std::string> validArgs = {
         "-r", "--region", "-i", "--inputPath", "-o", "--outputPath", 
         "-res", "--climateResolution", "-b", "--shapePath", "-s", "--stopDate",
+        "-ip", "--interp", "-qa", "--qa", "-mv", "--missingValues",
+        "-pet", "--derivePet", "-var", "--variables", "-io", "--ioBackend",
+        "-sh", "--shardBy", "-os", "--onlyShards", "-pk", "--pack",
+        "-mm", "--maxMemory", "-ts", "--tiles", "-tl", "--tile", "-tj", "--tileJobs", "-mt", "--mergeTiles",
+        "-sv", "--serve", "-sk", "--socket", "-sw", "--workers",
         "-h", "--help"
     };
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if (arg[0] == '-') {
+        if (isOptionName(argv[i])) {
             bool found = false;
             for (const auto& valid : validArgs) {
                 if (arg == valid) {
@@ -65,7 +100,7 @@ int main(int argc, char * argv[]) {
                 return 1;
             }
             // Skip value
-            if (i + 1 < argc && argv[i+1][0] != '-') {
+            if (i + 1 < argc && !isOptionName(argv[i+1])) {
                 i++;
             }
         }
@@ -84,6 +119,22 @@ int main(int argc, char * argv[]) {
     char* resOpt = getOption("-res", "--climateResolution");
     char* shapeOpt = getOption("-b", "--shapePath");
     char* dateOpt = getOption("-s", "--stopDate");
+    char* interpOpt = getOption("-ip", "--interp");
+    char* qaOpt = getOption("-qa", "--qa");
+    char* missingOpt = getOption("-mv", "--missingValues");
+    char* petOpt = getOption("-pet", "--derivePet");
+    char* variablesOpt = getOption("-var", "--variables");
+    char* ioOpt = getOption("-io", "--ioBackend");
+    char* shardOpt = getOption("-sh", "--shardBy");
+    char* onlyShardsOpt = getOption("-os", "--onlyShards");
+    char* maxMemoryOpt = getOption("-mm", "--maxMemory");
+    char* tilesOpt = getOption("-ts", "--tiles");
+    char* tileOpt = getOption("-tl", "--tile");
+    char* tileJobsOpt = getOption("-tj", "--tileJobs");
+    char* mergeOpt = getOption("-mt", "--mergeTiles");
+    char* socketOpt = getOption("-sk", "--socket");
+    char* workersOpt = getOption("-sw", "--workers");
+    bool serve = cmdOptionExists(argv, argv + argc, "-sv") || cmdOptionExists(argv, argv + argc, "--serve");
 
     if (!regionOpt || !inputPathOpt || !outputPathOpt) {
         std::cerr << "Error: Missing required arguments." << std::endl;
@@ -98,8 +149,129 @@ int main(int argc, char * argv[]) {
     std::string shapePath = shapeOpt ? shapeOpt : "";
     std::string stopDate = dateOpt ? dateOpt : "2500-12-31";
 
+    InterpolationMode interpolation = InterpolationMode::None;
+    if (interpOpt && !parseInterpolationMode(interpOpt, interpolation)) {
+        std::cerr << "Error: Unknown interpolation mode '" << interpOpt << "'. Use none, nearest or idw." << std::endl;
+        return 1;
+    }
+
+    bool runQuality = qaOpt || missingOpt;
+    QualityOptions qualityOptions;
+    if (qaOpt && !parseRangeAction(qaOpt, qualityOptions.action)) {
+        std::cerr << "Error: Unknown QA action '" << qaOpt << "'. Use flag, clip or mask." << std::endl;
+        return 1;
+    }
+    if (missingOpt) {
+        qualityOptions.sentinels.clear();
+        std::stringstream ss(missingOpt);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            try {
+                qualityOptions.sentinels.push_back(std::stod(item));
+            } catch (...) {
+                std::cerr << "Error: Invalid missing value '" << item << "'." << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    PetMethod petMethod = PetMethod::Hargreaves;
+    if (petOpt && !parsePetMethod(petOpt, petMethod)) {
+        std::cerr << "Error: Unknown PET method '" << petOpt << "'. Use hargreaves or priestley-taylor." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> variables;
+    if (variablesOpt && !Utils::parseVariableList(variablesOpt, variables)) {
+        std::cerr << "Error: Invalid variable list '" << variablesOpt << "'. Use a comma-separated list of pcp, tmp, slr, hmd, wnd and pet." << std::endl;
+        return 1;
+    }
+
+    IoBackend ioBackend = IoBackend::Auto;
+    if (ioOpt && !parseIoBackend(ioOpt, ioBackend)) {
+        std::cerr << "Error: Unknown I/O backend '" << ioOpt << "'. Use auto, uring or posix." << std::endl;
+        return 1;
+    }
+
+    ShardSpec shardSpec;
+    if (shardOpt && !parseShardSpec(shardOpt, shardSpec)) {
+        std::cerr << "Error: Invalid shard spec '" << shardOpt << "'. Use year, decade or a number of days." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> onlyShards;
+    if (onlyShardsOpt) {
+        std::stringstream ss(onlyShardsOpt);
+        std::string label;
+        while (std::getline(ss, label, ',')) {
+            if (!label.empty()) onlyShards.push_back(label);
+        }
+    }
+
+    size_t maxMemory = 0;
+    if (maxMemoryOpt && !parseMemorySize(maxMemoryOpt, maxMemory)) {
+        std::cerr << "Error: Invalid memory size '" << maxMemoryOpt << "'. Use bytes or a K, M or G suffix, e.g. 8G." << std::endl;
+        return 1;
+    }
+
+    TileSpec tileSpec;
+    if (tilesOpt && !parseTileLayout(tilesOpt, tileSpec)) {
+        std::cerr << "Error: Invalid tile layout '" << tilesOpt << "'. Use RxC, e.g. 4x8." << std::endl;
+        return 1;
+    }
+    if (tileOpt && !parseTileIndex(tileOpt, tileSpec)) {
+        std::cerr << "Error: Invalid tile '" << tileOpt << "'. Use i/N with 1 <= i <= N." << std::endl;
+        return 1;
+    }
+    size_t tileJobs = std::max(1u, std::thread::hardware_concurrency());
+    if (tileJobsOpt) {
+        try {
+            tileJobs = std::max(1, std::stoi(tileJobsOpt));
+        } catch (...) {
+            std::cerr << "Error: Invalid number of tile jobs '" << tileJobsOpt << "'." << std::endl;
+            return 1;
+        }
+    }
+    int mergeCount = 0;
+    if (mergeOpt) {
+        try {
+            mergeCount = std::stoi(mergeOpt);
+        } catch (...) {}
+        if (mergeCount < 1) {
+            std::cerr << "Error: Invalid number of tiles to merge '" << mergeOpt << "'." << std::endl;
+            return 1;
+        }
+    }
+    if (tileSpec.enabled() && shardOpt) {
+        std::cerr << "Error: --tiles/--tile cannot be combined with --shardBy." << std::endl;
+        return 1;
+    }
+    if (tileSpec.enabled() && maxMemoryOpt) {
+        std::cerr << "Error: --maxMemory applies to untiled runs; tiles already bound memory per process." << std::endl;
+        return 1;
+    }
+
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    if (workersOpt) {
+        try {
+            workers = std::max(1, std::stoi(workersOpt));
+        } catch (...) {
+            std::cerr << "Error: Invalid number of workers '" << workersOpt << "'." << std::endl;
+            return 1;
+        }
+    }
+    if (serve && (tileSpec.enabled() || mergeOpt || shardOpt || maxMemoryOpt)) {
+        std::cerr << "Error: --serve keeps every station in memory and cannot be combined with --tiles, --tile, --mergeTiles, --shardBy or --maxMemory." << std::endl;
+        return 1;
+    }
+
     if (!fs::exists(inputPath)) {
-        std::cerr << "Error: Input directory '" << inputPath << "' does not exist." << std::endl;
+        std::cerr << "Error: Input path '" << inputPath << "' does not exist." << std::endl;
+        return 1;
+    }
+    // Archives are read in one pass; tiles and --maxMemory re-open station files by path
+    bool archiveInput = Archive::isArchive(inputPath);
+    if (archiveInput && (tileSpec.enabled() || mergeOpt || maxMemoryOpt)) {
+        std::cerr << "Error: --tiles, --tile, --mergeTiles and --maxMemory read station files by path; extract the archive first." << std::endl;
         return 1;
     }
 
@@ -108,62 +280,127 @@ int main(int argc, char * argv[]) {
         return 1;
     }
 
+    // Without --variables, convert what the model reads from files (the non-null climate entries).
+    // An archive's file.cio is only seen during the single pass, so the converter applies it when reached.
+    if (!variablesOpt && !archiveInput) {
+        variables = Utils::climateVariables(inputPath);
+    }
+    auto addDerivedPet = [&]() {
+        if (!petOpt || variables.empty()) return true;
+        if (std::find(variables.begin(), variables.end(), "tmp") == variables.end()) {
+            std::cerr << "Error: --derivePet needs tmp among the converted variables." << std::endl;
+            return false;
+        }
+        if (std::find(variables.begin(), variables.end(), "pet") == variables.end()) variables.push_back("pet");
+        return true;
+    };
+    if (!addDerivedPet()) {
+        return 1;
+    }
+
+    Converter converter(region, inputPath, outputPath);
+    converter.setInterpolation(interpolation);
+    converter.setIoBackend(ioBackend);
+    converter.setVariables(variables);
+    converter.setSharding(shardSpec, onlyShards);
+    converter.setMaxMemory(maxMemory);
+    converter.setPacking(cmdOptionExists(argv, argv + argc, "-pk") || cmdOptionExists(argv, argv + argc, "--pack"));
+    if (runQuality) {
+        converter.setQualityControl(qualityOptions);
+    }
+    if (petOpt) {
+        converter.setPetMethod(petMethod);
+    }
+
+    if (archiveInput) {
+        // Stations and the model files come out of the same sequential pass over the archive
+        std::cout << "Reading archive " << inputPath << "..." << std::endl;
+        if (!variablesOpt) converter.selectClimateVariables();
+        converter.processWeatherFiles();
+        if (!variablesOpt) {
+            variables = converter.variables();
+            if (!addDerivedPet()) {
+                return 1;
+            }
+            converter.restrictVariables(variables);
+        }
+    }
+
     std::cout << "Starting SWAT+ NetCDF Converter (C++ Prototype)" << std::endl;
     std::cout << "Region: " << region << std::endl;
     std::cout << "Input: " << inputPath << std::endl;
     std::cout << "Output: " << outputPath << std::endl;
+    std::cout << "Interpolation: " << interpolationModeName(interpolation) << std::endl;
+    if (!variables.empty()) {
+        std::cout << "Variables:";
+        for (const auto& group : variables) std::cout << " " << group;
+        std::cout << std::endl;
+    }
 
     // 1. Prepare Directories and Copy Files (Logic from convertSWATWeather)
     if (Utils::createDirectory(outputPath)) {
         std::cout << "Created output directory." << std::endl;
     }
 
-    bool fileCioExists = fs::exists(inputPath + "/file.cio");
+    bool fileCioExists = archiveInput ? converter.archiveFiles().count("file.cio") > 0 : fs::exists(inputPath + "/file.cio");
 
-    if (fileCioExists) {
-        // Copy essential files
-        std::vector<std::string> files = Utils::listFiles(inputPath);
-        
-        // Bad extensions to skip
-        std::vector<std::string> badExtensions = {".cli", ".tmp", ".wnd", ".slr", ".hmd", ".pcp", ".tem"};
-        
-        for (const auto& file : files) {
-            std::string filename = file.substr(file.find_last_of("/\\") + 1);
-            
-            // Filter logic: skip .txt
-            if (filename.length() >= 4 && filename.substr(filename.length() - 4) == ".txt") continue;
-            
-            // Skip weather-sta.cli
-            if (filename == "weather-sta.cli") continue;
-
-            // Skip bad extensions
-            bool isBad = false;
-            for (const auto& ext : badExtensions) {
-                if (filename.length() >= ext.length() && 
-                    filename.substr(filename.length() - ext.length()) == ext) {
-                    isBad = true;
-                    break;
-                }
-            }
-            if (isBad) continue;
-
-            Utils::copyFile(file, outputPath + "/" + filename);
+    // Single-tile runs leave the shared output files to the run that merges the tiles
+    if (tileOpt) {
+        std::cout << "Converting a single tile. Skipping file copy and update." << std::endl;
+    } else if (serve) {
+        std::cout << "Serving requests. Skipping file copy and update." << std::endl;
+    } else if (fileCioExists && archiveInput) {
+        for (const auto& [filename, content] : converter.archiveFiles()) {
+            if (Utils::isModelInputFile(filename)) Utils::writeFile(outputPath + "/" + filename, content);
         }
-        
-        // Explicitly copy weather-wgn.cli if it exists
-        std::string wgnFile = inputPath + "/weather-wgn.cli";
-        if (fs::exists(wgnFile)) {
-             Utils::copyFile(wgnFile, outputPath + "/weather-wgn.cli");
+        Utils::writeFileCIO(converter.archiveFiles().at("file.cio"), outputPath, region, variables);
+    } else if (fileCioExists) {
+        // Copy the model files; station files are replaced by the NetCDF output
+        for (const auto& file : Utils::listFiles(inputPath)) {
+            std::string filename = file.substr(file.find_last_of("/\\") + 1);
+            if (Utils::isModelInputFile(filename)) Utils::copyFile(file, outputPath + "/" + filename);
         }
-        
+
         // Update file.cio
-        Utils::updateFileCIO(inputPath, outputPath, region);
+        Utils::updateFileCIO(inputPath, outputPath, region, variables);
     } else {
         std::cout << "file.cio not found. Skipping file copy and update." << std::endl;
     }
 
     // 2. Run Conversion (Logic from swatPlusNetCDFConverter)
-    Converter converter(region, inputPath, outputPath);
+    if (mergeOpt) {
+        return converter.mergeTiles(mergeCount) ? 0 : 1;
+    }
+
+    if (serve) {
+        // Parse once; every request is then answered from the in-memory stations
+        if (!archiveInput) converter.processWeatherFiles();
+        if (runQuality) {
+            converter.applyQualityControl();
+        }
+        if (petOpt) {
+            converter.derivePet(petMethod);
+        }
+        std::string socketPath = socketOpt ? socketOpt : outputPath + "/" + region + ".sock";
+        return Server::run(converter, socketPath, workers) ? 0 : 1;
+    }
+
+    if (tileSpec.enabled() && tileSpec.index < 0) {
+        // One child process per tile (each re-reads only its stations), then a merge
+        std::cout << "Converting " << tileSpec.count() << " tiles (" << tileSpec.rows << "x" << tileSpec.cols
+                  << ") with up to " << tileJobs << " processes..." << std::endl;
+        std::vector<std::string> args(argv, argv + argc);
+        if (!Tiling::runProcesses(args, tileSpec.count(), tileJobs, outputPath + "/" + region + "_tile")) {
+            return 1;
+        }
+        return converter.mergeTiles(tileSpec.count()) ? 0 : 1;
+    }
+
+    if (tileSpec.enabled()) {
+        converter.setTiling(tileSpec);
+        return converter.convertTile(resolution, shapePath) ? 0 : 1;
+    }
+
     converter.run(resolution, shapePath, stopDate);
 
     return 0;
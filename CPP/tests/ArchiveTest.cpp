@@ -0,0 +1,171 @@
+#include "Check.h"
+#include "Archive.h"
+#include "Converter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+// Archives are built here byte by byte (tar, gzip members, stored and deflated zip entries)
+// so the reader is checked against the formats rather than against another tool's output
+
+namespace {
+
+std::string tarHeader(const std::string& name, size_t size, char type) {
+    std::string header(512, '\0');
+    std::memcpy(&header[0], name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(&header[100], 8, "%07o", 0644);
+    std::snprintf(&header[108], 8, "%07o", 0);
+    std::snprintf(&header[116], 8, "%07o", 0);
+    std::snprintf(&header[124], 12, "%011lo", static_cast<unsigned long>(size));
+    std::snprintf(&header[136], 12, "%011o", 0);
+    header[156] = type;
+    std::memcpy(&header[257], "ustar", 6);
+    std::memcpy(&header[263], "00", 2);
+    std::memset(&header[148], ' ', 8);
+    unsigned sum = 0;
+    for (unsigned char c : header) sum += c;
+    std::snprintf(&header[148], 8, "%06o", sum);
+    return header;
+}
+
+std::string tarEntry(const std::string& name, const std::string& content, char type = '0') {
+    return tarHeader(name, content.size(), type) + content + std::string((512 - content.size() % 512) % 512, '\0');
+}
+
+// gzip member (windowBits + 16) or raw deflate (negative windowBits)
+std::string deflateBytes(const std::string& data, int windowBits) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, static_cast<uLong>(data.size())) + 32, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+void put16(std::string& out, uint32_t v) { out += static_cast<char>(v & 0xFF); out += static_cast<char>((v >> 8) & 0xFF); }
+void put32(std::string& out, uint32_t v) { put16(out, v & 0xFFFF); put16(out, v >> 16); }
+
+struct ZipFile {
+    std::string name, content;
+    bool deflated;
+};
+
+std::string zipArchive(const std::vector<ZipFile>& files) {
+    std::string body, directory;
+    for (const auto& f : files) {
+        std::string stored = f.deflated ? deflateBytes(f.content, -MAX_WBITS) : f.content;
+        uint32_t crc = crc32(0L, reinterpret_cast<const Bytef*>(f.content.data()), static_cast<uInt>(f.content.size()));
+        uint32_t offset = static_cast<uint32_t>(body.size());
+        auto common = [&](std::string& out) {
+            put16(out, 20); put16(out, 0); put16(out, f.deflated ? 8 : 0); put16(out, 0); put16(out, 0);
+            put32(out, crc); put32(out, static_cast<uint32_t>(stored.size())); put32(out, static_cast<uint32_t>(f.content.size()));
+            put16(out, static_cast<uint32_t>(f.name.size())); put16(out, 0);
+        };
+        put32(body, 0x04034b50);
+        common(body);
+        body += f.name + stored;
+
+        put32(directory, 0x02014b50);
+        put16(directory, 20);
+        common(directory);
+        put16(directory, 0); put16(directory, 0); put16(directory, 0); put32(directory, 0);
+        put32(directory, offset);
+        directory += f.name;
+    }
+    std::string end;
+    put32(end, 0x06054b50);
+    put16(end, 0); put16(end, 0);
+    put16(end, static_cast<uint32_t>(files.size())); put16(end, static_cast<uint32_t>(files.size()));
+    put32(end, static_cast<uint32_t>(directory.size())); put32(end, static_cast<uint32_t>(body.size()));
+    put16(end, 0);
+    return body + directory + end;
+}
+
+std::map<std::string, std::string> entries(const std::string& path, bool& ok) {
+    std::map<std::string, std::string> out;
+    ok = Archive::read(path, [&](const std::string& name, std::string& content) { out[name] = content; });
+    return out;
+}
+
+}
+
+int main() {
+    Check::TempDir dir("archive");
+    const std::string station = Check::stationFile(0, 44.0, -93.0, 200, "1980 1 1.0\n1980 2 2.0\n1980 3 3.0\n");
+    const std::string sta = "weather-sta.cli: test\nname wgn pcp tmp slr hmd wnd wnd_dir atmo_dep\n"
+                            "a wgn1 a.pcp null null null null null null\n";
+    const std::string longName = "TxtInOut/" + std::string(120, 'd') + ".txt";
+
+    // Directory entries are skipped and a GNU long name applies to the entry after it
+    std::string tar = tarEntry("TxtInOut/", "", '5') + tarEntry("TxtInOut/weather-sta.cli", sta) +
+                      tarEntry("TxtInOut/a.pcp", station) + tarEntry("././@LongLink", longName + '\0', 'L') +
+                      tarEntry("truncated-name", "long") + std::string(1024, '\0');
+    Check::writeFile(dir.file("in.tar"), tar);
+    bool ok = false;
+    auto files = entries(dir.file("in.tar"), ok);
+    CHECK(ok && files.size() == 3);
+    CHECK(files["TxtInOut/a.pcp"] == station && files["TxtInOut/weather-sta.cli"] == sta);
+    CHECK(files[longName] == "long");
+
+    // Gzip, including a stream of two concatenated members split inside an entry
+    Check::writeFile(dir.file("in.tar.gz"), deflateBytes(tar, MAX_WBITS + 16));
+    auto gz = entries(dir.file("in.tar.gz"), ok);
+    CHECK(ok && gz == files);
+    Check::writeFile(dir.file("split.tgz"), deflateBytes(tar.substr(0, 1000), MAX_WBITS + 16) + deflateBytes(tar.substr(1000), MAX_WBITS + 16));
+    CHECK(entries(dir.file("split.tgz"), ok) == files && ok);
+
+    // Truncation is reported; entries before it have been delivered
+    Check::writeFile(dir.file("cut.tar"), tar.substr(0, 512 * 4));
+    auto cut = entries(dir.file("cut.tar"), ok);
+    CHECK(!ok && cut.size() == 1 && cut.count("TxtInOut/weather-sta.cli"));
+    std::string compressed = deflateBytes(tar, MAX_WBITS + 16);
+    Check::writeFile(dir.file("cut.tar.gz"), compressed.substr(0, compressed.size() / 2));
+    entries(dir.file("cut.tar.gz"), ok);
+    CHECK(!ok);
+    Check::writeFile(dir.file("noend.tar"), tar.substr(0, tar.size() - 1024));
+    entries(dir.file("noend.tar"), ok);
+    CHECK(!ok);
+
+    // Zip: stored and deflated entries, read in stored order; a bad CRC fails the read
+    std::vector<ZipFile> zipFiles = {{"TxtInOut/", "", false}, {"TxtInOut/weather-sta.cli", sta, false}, {"TxtInOut/a.pcp", station, true}};
+    Check::writeFile(dir.file("in.zip"), zipArchive(zipFiles));
+    auto zip = entries(dir.file("in.zip"), ok);
+    CHECK(ok && zip.size() == 2 && zip["TxtInOut/a.pcp"] == station && zip["TxtInOut/weather-sta.cli"] == sta);
+    std::string damaged = zipArchive(zipFiles);
+    damaged[damaged.find("a wgn1")] = 'X'; // inside the stored weather-sta.cli
+    Check::writeFile(dir.file("crc.zip"), damaged);
+    entries(dir.file("crc.zip"), ok);
+    CHECK(!ok);
+    Check::writeFile(dir.file("short.zip"), "PK");
+    entries(dir.file("short.zip"), ok);
+    CHECK(!ok);
+
+    CHECK(Archive::isArchive(dir.file("in.tar")) && Archive::isArchive(dir.file("split.tgz")) && Archive::isArchive(dir.file("in.zip")));
+    CHECK(!Archive::isArchive(dir.file("missing.zip")));
+    std::filesystem::create_directory(dir.file("folder.zip"));
+    CHECK(!Archive::isArchive(dir.file("folder.zip")));
+
+    // The converter reads stations straight from the archive
+    Converter converter("test", dir.file("in.tar.gz"), dir.path());
+    converter.processWeatherFiles();
+    const VariableData* pcp = converter.findVariable("pcp");
+    CHECK(pcp && pcp->stations.size() == 1);
+    if (pcp && pcp->stations.size() == 1) {
+        CHECK(pcp->stations[0].data == std::vector<double>({1.0, 2.0, 3.0}));
+        CHECK(pcp->stations[0].lat == 44.0 && pcp->stations[0].startYear == 1980);
+    }
+
+    return Check::result();
+}
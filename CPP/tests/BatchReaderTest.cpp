@@ -0,0 +1,53 @@
+#include "Check.h"
+#include "BatchReader.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string content(size_t i) {
+    // Mostly small station-like files, one empty and one larger than a typical first read
+    if (i == 3) return "";
+    if (i == 7) return std::string(300000, 'x') + "end";
+    return "file " + std::to_string(i) + "\n" + std::string(i % 50, '.');
+}
+
+}
+
+int main() {
+    Check::TempDir dir("batch");
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 300; ++i) {
+        paths.push_back(dir.file("f" + std::to_string(i) + ".txt"));
+        if (i != 11) Check::writeFile(paths.back(), content(i)); // f11 does not exist
+    }
+
+    CHECK(BatchReader::resolve(IoBackend::Posix) == IoBackend::Posix);
+    CHECK(BatchReader::backendName(IoBackend::Posix) == "posix");
+    IoBackend automatic = BatchReader::resolve(IoBackend::Auto);
+    CHECK(automatic == IoBackend::Uring || automatic == IoBackend::Posix);
+
+    // Every backend delivers each readable file once, in input order, across batch boundaries
+    for (IoBackend backend : {IoBackend::Auto, IoBackend::Uring, IoBackend::Posix}) {
+        for (size_t batch : {size_t(1), size_t(64), size_t(256)}) {
+            std::vector<size_t> order;
+            bool contentOk = true;
+            BatchReader::readFiles(paths, [&](size_t index, std::string& text) {
+                order.push_back(index);
+                contentOk = contentOk && text == content(index);
+            }, backend, batch);
+
+            CHECK(contentOk);
+            CHECK(order.size() == 299);
+            bool inOrder = true;
+            for (size_t k = 0; k < order.size(); ++k) inOrder = inOrder && order[k] == (k < 11 ? k : k + 1);
+            CHECK(inOrder);
+        }
+    }
+
+    IoBackend parsed;
+    CHECK(parseIoBackend("uring", parsed) && parsed == IoBackend::Uring);
+    CHECK(!parseIoBackend("aio", parsed));
+
+    return Check::result();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Minimal checks shared by the module tests. A failed CHECK is reported with its
+// location and makes Check::result() (returned from main) non-zero.
+namespace Check {
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void report(bool ok, const char* expression, const char* file, int line) {
+        if (ok) return;
+        ++failures();
+        std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+    }
+
+    inline int result() {
+        if (failures() > 0) std::cerr << failures() << " check(s) failed" << std::endl;
+        return failures() > 0 ? 1 : 0;
+    }
+
+    inline void writeFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream out(path, std::ios::binary);
+        out << content;
+    }
+
+    // Station file as SWAT+ writes it: title, column header, "nbyr tstep lat lon elev", then the rows
+    inline std::string stationFile(int tstep, double lat, double lon, double elev, const std::string& rows) {
+        return "station: test\nnbyr tstep lat lon elev\n 1 " + std::to_string(tstep) + " " + std::to_string(lat) + " " +
+               std::to_string(lon) + " " + std::to_string(elev) + "\n" + rows;
+    }
+
+    // Fresh directory under the system temp directory, removed with its contents on destruction
+    class TempDir {
+    public:
+        explicit TempDir(const std::string& name)
+            : m_path(std::filesystem::temp_directory_path() / ("swat2netcdf_" + name)) {
+            std::filesystem::remove_all(m_path);
+            std::filesystem::create_directories(m_path);
+        }
+        ~TempDir() {
+            std::error_code ec;
+            std::filesystem::remove_all(m_path, ec);
+        }
+        std::string path() const { return m_path.string(); }
+        std::string file(const std::string& name) const { return (m_path / name).string(); }
+
+    private:
+        std::filesystem::path m_path;
+    };
+}
+
+#define CHECK(expression) Check::report(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tolerance) Check::report(std::fabs((a) - (b)) <= (tolerance), #a " == " #b, __FILE__, __LINE__)
@@ -0,0 +1,88 @@
+#include "Check.h"
+#include "Converter.h"
+#include <vector>
+
+// In-process API: load a small TxtInOut, define the grid and grid blocks into caller memory
+
+namespace {
+
+void writeTxtInOut(const Check::TempDir& dir) {
+    Check::writeFile(dir.file("weather-sta.cli"),
+                     "weather-sta.cli: test\nname wgn pcp tmp slr hmd wnd wnd_dir atmo_dep\n"
+                     "a wgn1 a.pcp a.tmp null null null null null\n"
+                     "b wgn1 b.pcp b.tmp null null null null null\n"
+                     "c wgn1 c.pcp c.tmp null null null null null\n");
+    Check::writeFile(dir.file("a.pcp"), Check::stationFile(0, 44.0, -93.0, 200, "1980 1 1.0\n1980 2 2.0\n1980 3 3.0\n"));
+    Check::writeFile(dir.file("b.pcp"), Check::stationFile(0, 45.0, -92.0, 210, "1980 2 20.0\n1980 3 30.0\n"));
+    Check::writeFile(dir.file("c.pcp"), Check::stationFile(0, 44.5, -92.5, 220, "1980 1 100.0\n1980 2 200.0\n1980 3 300.0\n"));
+    Check::writeFile(dir.file("a.tmp"), Check::stationFile(0, 44.0, -93.0, 200, "1980 1 25.0 10.0\n1980 2 26.0 11.0\n1980 3 27.0 12.0\n"));
+    Check::writeFile(dir.file("b.tmp"), Check::stationFile(0, 45.0, -92.0, 210, "1980 2 20.0 5.0\n1980 3 21.0 6.0\n"));
+    Check::writeFile(dir.file("c.tmp"), Check::stationFile(0, 44.5, -92.5, 220, "1980 1 15.0 1.0\n1980 2 16.0 2.0\n1980 3 17.0 3.0\n"));
+}
+
+const Station* findStation(const VariableData* vd, const std::string& name) {
+    if (!vd) return nullptr;
+    for (const auto& st : vd->stations) if (st.name == name) return &st;
+    return nullptr;
+}
+
+}
+
+int main() {
+    Check::TempDir dir("converter");
+    writeTxtInOut(dir);
+
+    Converter converter("test", dir.path(), dir.path());
+    CHECK(!converter.stationsLoaded());
+    converter.processWeatherFiles();
+    CHECK(converter.stationsLoaded());
+
+    // Variables come out in registry order, one station per file
+    const auto& data = converter.weatherData();
+    CHECK(data.size() == 3);
+    if (data.size() == 3) {
+        CHECK(data[0].name == "pcp");
+        CHECK(data[1].name == "tmax");
+        CHECK(data[2].name == "tmin");
+    }
+    const VariableData* pcp = converter.findVariable("pcp");
+    CHECK(pcp && pcp->stations.size() == 3);
+    const Station* a = findStation(pcp, "a.pcp");
+    CHECK(a && a->data == std::vector<double>({1.0, 2.0, 3.0}));
+    CHECK(a && a->startYear == 1980 && a->startDay == 1);
+    CHECK(a && a->lat == 44.0 && a->lon == -93.0 && a->elev == 200.0);
+    const Station* b = findStation(converter.findVariable("tmin"), "b.tmp");
+    CHECK(b && b->startDay == 2 && b->data == std::vector<double>({5.0, 6.0}));
+    CHECK(converter.findVariable("wnd") == nullptr);
+
+    // Station extent plus one cell on each side; the time axis spans every record
+    GridSpec grid = converter.defineGrid(0.5, false);
+    CHECK(grid.nLat == 5 && grid.nLon == 5);
+    CHECK(grid.startYear == 1980 && grid.startDay == 1 && grid.nTime == 3 && grid.stepsPerDay == 1);
+
+    // Without interpolation each station fills only its own cell
+    std::vector<float> block(grid.nTime * grid.cellCount(), 0.0f);
+    CHECK(converter.gridVariable("pcp", grid, 0, grid.nTime, block.data()) == 3);
+    const size_t cells = grid.cellCount(), cellA = 1 * 5 + 1, cellB = 3 * 5 + 3, cellC = 2 * 5 + 2;
+    CHECK(block[0 * cells + cellA] == 1.0f);
+    CHECK(block[2 * cells + cellA] == 3.0f);
+    CHECK(block[0 * cells + cellB] == Converter::kMissingValue); // b starts on day 2
+    CHECK(block[1 * cells + cellB] == 20.0f);
+    CHECK(block[2 * cells + cellC] == 300.0f);
+    CHECK(block[0] == Converter::kMissingValue);
+
+    // A window of the time axis lands at the start of the buffer
+    CHECK(converter.gridVariable("tmin", grid, 1, 2, block.data()) == 2);
+    CHECK(block[0 * cells + cellA] == 11.0f);
+    CHECK(block[1 * cells + cellB] == 6.0f);
+    CHECK(converter.gridVariable("wnd", grid, 0, grid.nTime, block.data()) == 0);
+
+    // Unselected groups are never loaded
+    Converter selective("test", dir.path(), dir.path());
+    selective.setVariables({"pcp"});
+    selective.processWeatherFiles();
+    CHECK(selective.findVariable("pcp") != nullptr);
+    CHECK(selective.findVariable("tmax") == nullptr);
+
+    return Check::result();
+}
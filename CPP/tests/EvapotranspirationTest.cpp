@@ -0,0 +1,105 @@
+#include "Check.h"
+#include "Converter.h"
+#include "Evapotranspiration.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const double kFill = Converter::kMissingValue;
+
+Station station(const std::string& name, double lat, double lon, int startDay, const std::vector<double>& data) {
+    Station st{};
+    st.name = name;
+    st.lat = lat;
+    st.lon = lon;
+    st.elev = 300.0;
+    st.startYear = 2001;
+    st.startDay = startDay;
+    st.data = data;
+    return st;
+}
+
+VariableData variable(VariableId id, const std::vector<Station>& stations) {
+    const VariableDescriptor& descriptor = Variables::variable(id);
+    return {id, descriptor.name, descriptor.unit, stations};
+}
+
+}
+
+int main() {
+    // FAO-56 example 8: 20 degrees south on 3 September
+    CHECK_NEAR(Evapotranspiration::extraterrestrialRadiation(-20.0, 246), 32.2, 0.05);
+    CHECK(Evapotranspiration::extraterrestrialRadiation(80.0, 355) == 0.0); // polar night
+
+    // Hargreaves: 0.0023 * Ra/lambda * (tmean + 17.8) * sqrt(tmax - tmin)
+    double tmax[] = {30.0, 25.0, kFill};
+    double tmin[] = {14.0, 25.0, 10.0};
+    double ra[] = {40.0, 40.0, 40.0};
+    double pet[3];
+    Evapotranspiration::hargreaves(tmax, tmin, ra, 3, kFill, pet);
+    CHECK_NEAR(pet[0], 0.0023 * (40.0 / 2.45) * (22.0 + 17.8) * 4.0, 1e-9);
+    CHECK(pet[1] == 0.0);
+    CHECK(pet[2] == kFill);
+
+    // Priestley-Taylor estimates missing radiation from the temperature range (FAO-56 eq. 50)
+    double estimated[3], measured[3];
+    double slr[] = {0.16 * 4.0 * 40.0, kFill, kFill};
+    Evapotranspiration::priestleyTaylor(tmax, tmin, nullptr, nullptr, ra, 300.0, 3, kFill, estimated);
+    Evapotranspiration::priestleyTaylor(tmax, tmin, slr, nullptr, ra, 300.0, 3, kFill, measured);
+    CHECK(estimated[0] > 0.0 && estimated[2] == kFill);
+    CHECK_NEAR(measured[0], estimated[0], 1e-9);
+
+    // derive: one PET station per temperature station; slr is taken from the co-located
+    // station and shifted onto the temperature station's days
+    std::vector<VariableData> weather = {
+        variable(VariableId::Slr, {station("far.slr", 10.0, 10.0, 1, {5.0, 5.0, 5.0, 5.0}),
+                                   station("a.slr", 45.0, -93.0, 1, {kFill, 20.0, 21.0, 22.0})}),
+        variable(VariableId::Tmax, {station("a.tmp", 45.0, -93.0, 2, {30.0, 31.0, 32.0}),
+                                    station("b.tmp", 44.0, -92.0, 1, {28.0, 29.0})}),
+        variable(VariableId::Tmin, {station("a.tmp", 45.0, -93.0, 2, {15.0, 16.0, 17.0}),
+                                    station("b.tmp", 44.0, -92.0, 1, {12.0, 13.0})}),
+    };
+    VariableData derived;
+    CHECK(Evapotranspiration::derive(weather, PetMethod::PriestleyTaylor, derived));
+    CHECK(derived.id == VariableId::Pet && derived.name == "pet" && derived.stations.size() == 2);
+    if (derived.stations.size() == 2) {
+        const Station& a = derived.stations[0];
+        CHECK(a.name == "a.tmp" && a.startDay == 2 && a.data.size() == 3);
+
+        const Station& hi = weather[1].stations[0];
+        const Station& lo = weather[2].stations[0];
+        std::vector<double> raA(3), expected(3);
+        for (int i = 0; i < 3; ++i) raA[i] = Evapotranspiration::extraterrestrialRadiation(45.0, 2 + i);
+        double aligned[] = {20.0, 21.0, 22.0};
+        Evapotranspiration::priestleyTaylor(hi.data.data(), lo.data.data(), aligned, nullptr, raA.data(), 300.0, 3,
+                                            kFill, expected.data());
+        for (int i = 0; i < 3 && a.data.size() == 3; ++i) CHECK_NEAR(a.data[i], expected[i], 1e-9);
+
+        // No slr station at b: radiation is estimated
+        const Station& b = derived.stations[1];
+        std::vector<double> raB = {Evapotranspiration::extraterrestrialRadiation(44.0, 1),
+                                   Evapotranspiration::extraterrestrialRadiation(44.0, 2)};
+        std::vector<double> estimatedB(2);
+        Evapotranspiration::priestleyTaylor(weather[1].stations[1].data.data(), weather[2].stations[1].data.data(),
+                                            nullptr, nullptr, raB.data(), 300.0, 2, kFill, estimatedB.data());
+        CHECK(b.data.size() == 2 && b.data[0] == estimatedB[0] && b.data[1] == estimatedB[1]);
+    }
+
+    // Sub-daily records and impossible start days produce no PET series
+    weather[1].stations[0].stepsPerDay = 24;
+    weather[1].stations[1].startDay = 366; // 2001 is not a leap year
+    CHECK(Evapotranspiration::derive(weather, PetMethod::Hargreaves, derived));
+    CHECK(derived.stations[0].startYear == -1 && derived.stations[1].startYear == -1);
+
+    // Temperature is required
+    std::vector<VariableData> noTemperature = {weather[0]};
+    CHECK(!Evapotranspiration::derive(noTemperature, PetMethod::Hargreaves, derived));
+
+    PetMethod method;
+    CHECK(parsePetMethod("priestley-taylor", method) && method == PetMethod::PriestleyTaylor);
+    CHECK(!parsePetMethod("penman", method));
+    CHECK(petMethodName(PetMethod::Hargreaves) == "hargreaves");
+
+    return Check::result();
+}
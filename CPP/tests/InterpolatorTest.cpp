@@ -0,0 +1,132 @@
+#include "Check.h"
+#include "Converter.h"
+#include "Interpolator.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const float kMissing = Converter::kMissingValue;
+
+Station station(double lat, double lon) {
+    Station st{};
+    st.lat = lat;
+    st.lon = lon;
+    st.startYear = 2000;
+    st.startDay = 1;
+    return st;
+}
+
+// One row of cells at the equator, 1 degree apart, so projected distances are plain degrees
+GridSpec row(int cells) {
+    GridSpec grid;
+    grid.resolution = 1.0;
+    grid.nLat = 1;
+    grid.nLon = cells;
+    grid.maxLon = cells - 1;
+    return grid;
+}
+
+// Brute-force inverse-distance weighting over the k nearest stations
+float bruteIdw(const std::vector<Station>& stations, const std::vector<float>& values, double lat, double lon, size_t k) {
+    std::vector<std::pair<double, size_t>> byDistance;
+    for (size_t s = 0; s < stations.size(); ++s) {
+        double dx = lon - stations[s].lon, dy = lat - stations[s].lat;
+        byDistance.emplace_back(dx * dx + dy * dy, s);
+    }
+    std::sort(byDistance.begin(), byDistance.end());
+    double num = 0, den = 0;
+    for (size_t j = 0; j < k; ++j) {
+        double w = 1.0 / byDistance[j].first;
+        num += w * values[byDistance[j].second];
+        den += w;
+    }
+    return static_cast<float>(num / den);
+}
+
+}
+
+int main() {
+    std::vector<Station> stations = {station(0, 0), station(0, 3), station(0, 9), station(0, 20)};
+    GridSpec grid = row(10);
+    std::vector<float> out(grid.cellCount());
+
+    // Nearest: the closest reporting station among the k neighbours
+    StationInterpolator nearest(stations, grid, InterpolationMode::Nearest, 2, 2.0, 0.0);
+    CHECK(nearest.neighbours() == 2);
+    CHECK(nearest.tableBytes() == grid.cellCount() * 2 * (sizeof(int) + sizeof(float)));
+    std::vector<float> values = {1, 2, 3, 4};
+    nearest.apply(values.data(), out.data());
+    CHECK(out[0] == 1 && out[2] == 2 && out[4] == 2 && out[7] == 3 && out[9] == 3);
+
+    values = {kMissing, 2, 3, 4};
+    nearest.apply(values.data(), out.data());
+    CHECK(out[0] == 2);
+
+    // Both neighbours of cell 0 silent: the search widens to the next reporting station
+    values = {kMissing, kMissing, 3, 4};
+    nearest.apply(values.data(), out.data());
+    CHECK(out[0] == 3 && out[4] == 3);
+    values = {kMissing, kMissing, kMissing, 4};
+    nearest.apply(values.data(), out.data());
+    CHECK(out[0] == 4 && out[9] == 4);
+    values = {kMissing, kMissing, kMissing, kMissing};
+    nearest.apply(values.data(), out.data());
+    CHECK(std::all_of(out.begin(), out.end(), [](float v) { return v == kMissing; }));
+    CHECK(nearest.usedStations(stations.size()) == std::vector<bool>({true, true, true, true}));
+
+    // IDW: 1/d^2 weights renormalized over the stations reporting today
+    StationInterpolator idw(stations, grid, InterpolationMode::Idw, 2, 2.0, 0.0);
+    values = {1, 2, 3, 4};
+    idw.apply(values.data(), out.data());
+    CHECK_NEAR(out[1], (1.0 * 1.0 + 2.0 * 0.25) / 1.25, 1e-5);
+    CHECK_NEAR(out[0], 1.0, 1e-5); // a station on the cell centre dominates
+    values = {kMissing, 2, 3, 4};
+    idw.apply(values.data(), out.data());
+    CHECK_NEAR(out[1], 2.0, 1e-5);
+    CHECK(idw.usedStations(stations.size()) == std::vector<bool>({true, true, true, false}));
+
+    // Stations without a record are never neighbours
+    stations[1].startYear = -1;
+    StationInterpolator reporting(stations, grid, InterpolationMode::Nearest, 1, 2.0, 0.0);
+    values = {1, 2, 3, 4};
+    reporting.apply(values.data(), out.data());
+    CHECK(out[4] == 1 && out[5] == 3);
+
+    // No stations: every cell is fill
+    StationInterpolator empty({}, grid, InterpolationMode::Idw);
+    values.clear();
+    empty.apply(values.data(), out.data());
+    CHECK(out[3] == kMissing);
+
+    // The KD-tree finds the same k nearest stations as a brute-force scan
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> coordinate(-5.0, 25.0);
+    std::uniform_real_distribution<float> value(0.0f, 100.0f);
+    std::vector<Station> scattered;
+    std::vector<float> scatteredValues;
+    for (int s = 0; s < 300; ++s) {
+        scattered.push_back(station(coordinate(random), coordinate(random)));
+        scatteredValues.push_back(value(random));
+    }
+    GridSpec square;
+    square.resolution = 1.0;
+    square.nLat = 20;
+    square.nLon = 20;
+    square.maxLat = square.maxLon = 19;
+    std::vector<float> gridded(square.cellCount());
+    StationInterpolator tree(scattered, square, InterpolationMode::Idw, 8, 2.0, 0.0);
+    tree.apply(scatteredValues.data(), gridded.data());
+    size_t mismatches = 0;
+    for (int lat = 0; lat < square.nLat; ++lat) {
+        for (int lon = 0; lon < square.nLon; ++lon) {
+            float expected = bruteIdw(scattered, scatteredValues, lat, lon, 8);
+            if (std::fabs(gridded[lat * square.nLon + lon] - expected) > 1e-3f * std::max(1.0f, expected)) ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    return Check::result();
+}
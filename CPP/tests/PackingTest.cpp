@@ -0,0 +1,89 @@
+#include "Check.h"
+#include "Converter.h"
+#include "Packing.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+const float kFill = Converter::kMissingValue;
+
+// Scalar reference in the same float arithmetic: clamp, round half away from zero,
+// fill maps to the packed fill value
+int16_t packOne(float value, const PackParams& params) {
+    if (value == kFill) return Packing::kFillValue;
+    float q = (value - static_cast<float>(params.offset)) * static_cast<float>(1.0 / params.scale);
+    q = std::min(std::max(q, -32767.0f), 32767.0f);
+    return static_cast<int16_t>(q >= 0.0f ? q + 0.5f : q - 0.5f);
+}
+
+VariableData series(VariableId id, const std::vector<std::vector<double>>& data) {
+    const VariableDescriptor& descriptor = Variables::variable(id);
+    VariableData vd{id, descriptor.name, descriptor.unit, {}};
+    for (const auto& values : data) {
+        Station st{};
+        st.startYear = 2000;
+        st.startDay = 1;
+        st.data = values;
+        vd.stations.push_back(st);
+    }
+    return vd;
+}
+
+}
+
+int main() {
+    CHECK(Packing::precision(VariableId::Pcp) == 0.1);
+    CHECK(Packing::precision(VariableId::Hmd) == 0.0001);
+
+    // Station range at the variable's precision, centred on a multiple of it
+    PackParams tmax = Packing::compute(series(VariableId::Tmax, {{-12.5, kFill, 30.25}, {kFill}, {41.0, 3.0}}), kFill);
+    CHECK(tmax.scale == 0.01);
+    CHECK_NEAR(tmax.offset, 14.25, 1e-9);
+
+    // No valid value: identity parameters
+    PackParams empty = Packing::compute(series(VariableId::Wnd, {{kFill, kFill}, {}}), kFill);
+    CHECK(empty.scale == 1.0 && empty.offset == 0.0);
+
+    // A range too wide for int16 at the precision spreads it over the whole int16 span
+    PackParams wide = Packing::fromBounds(VariableId::Pcp, 0.0, 10000.0);
+    CHECK_NEAR(wide.scale, 10000.0 / 65534.0, 1e-12);
+    CHECK_NEAR(wide.offset, 5000.0, 1e-9);
+
+    // Tiles: the valid range at the variable's precision, which every registered variable fits
+    PackParams fixed;
+    CHECK(Packing::fromRange(VariableId::Pcp, fixed));
+    CHECK(fixed.scale == 0.1);
+    CHECK_NEAR(fixed.offset, 1000.0, 1e-9);
+    for (const auto& v : Variables::kVariables) CHECK(Packing::fromRange(v.id, fixed) && fixed.scale == v.precision);
+
+    // The vectorized kernel agrees with the scalar reference, including clamping and fill
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> value(-400.0f, 400.0f);
+    std::vector<float> in(1027);
+    for (auto& v : in) v = value(random);
+    in[0] = kFill;
+    in[1] = 1e6f;
+    in[2] = -1e6f;
+    in[3] = 14.25f;
+    in[4] = 14.255f;
+    in[5] = 14.245f;
+    in[1026] = kFill;
+    std::vector<int16_t> out(in.size());
+    Packing::pack(in.data(), in.size(), tmax, kFill, out.data());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < in.size(); ++i) mismatches += out[i] != packOne(in[i], tmax);
+    CHECK(mismatches == 0);
+    CHECK(out[0] == Packing::kFillValue && out[1026] == Packing::kFillValue);
+    CHECK(out[1] == 32767 && out[2] == -32767);
+    CHECK(out[3] == 0);
+
+    // Unpacking recovers values within half a step
+    for (size_t i = 6; i < in.size(); ++i) {
+        double restored = out[i] * tmax.scale + tmax.offset;
+        if (std::fabs(in[i] - tmax.offset) < 300.0) CHECK_NEAR(restored, in[i], 0.5 * tmax.scale + 1e-4);
+    }
+
+    return Check::result();
+}
@@ -0,0 +1,119 @@
+#include "Check.h"
+#include "Converter.h"
+#include "QualityControl.h"
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const double kFill = Converter::kMissingValue;
+
+VariableData variable(VariableId id, const std::vector<std::vector<double>>& series) {
+    const VariableDescriptor& descriptor = Variables::variable(id);
+    VariableData vd{id, descriptor.name, descriptor.unit, {}};
+    for (size_t s = 0; s < series.size(); ++s) {
+        Station st{};
+        st.name = "st" + std::to_string(s);
+        st.startYear = 2000;
+        st.startDay = 1;
+        st.data = series[s];
+        vd.stations.push_back(st);
+    }
+    return vd;
+}
+
+// Longer than one QA chunk and not a multiple of any vector width: 0..99 repeating,
+// a -99 sentinel every 1000 values, one value below and one above the pcp range
+std::vector<double> precipitation() {
+    std::vector<double> v(5001);
+    for (size_t i = 0; i < v.size(); ++i) v[i] = static_cast<double>(i % 100);
+    for (size_t i = 0; i < v.size(); i += 1000) v[i] = -99.0;
+    v[10] = -5.0;
+    v[4999] = 2500.0;
+    return v;
+}
+
+}
+
+int main() {
+    QualityOptions options;
+
+    for (RangeAction action : {RangeAction::Flag, RangeAction::Clip, RangeAction::Mask}) {
+        options.action = action;
+        std::vector<VariableData> data = {variable(VariableId::Pcp, {precipitation(), {1.0, -999.0}})};
+        std::vector<VariableQaStats> stats = QualityControl::run(data, options);
+        CHECK(stats.size() == 1);
+        if (stats.size() != 1) continue;
+        const VariableQaStats& pcp = stats[0];
+        const std::vector<double>& v = data[0].stations[0].data;
+
+        CHECK(pcp.id == VariableId::Pcp && pcp.name == "pcp");
+        CHECK(pcp.values == 5003);
+        CHECK(pcp.sentinels == 7); // six -99 plus one -999
+        CHECK(v[0] == kFill && v[5000] == kFill && data[0].stations[1].data[1] == kFill);
+        CHECK(pcp.belowRange == 1 && pcp.aboveRange == 1);
+        if (action == RangeAction::Flag) {
+            CHECK(pcp.missing == 7);
+            CHECK(v[10] == -5.0 && v[4999] == 2500.0);
+            CHECK(pcp.min == -5.0 && pcp.max == 2500.0);
+        } else if (action == RangeAction::Clip) {
+            CHECK(pcp.missing == 7);
+            CHECK(v[10] == 0.0 && v[4999] == 2000.0);
+            CHECK(pcp.min == 0.0 && pcp.max == 2000.0);
+        } else {
+            CHECK(pcp.missing == 9);
+            CHECK(v[10] == kFill && v[4999] == kFill);
+            CHECK(pcp.min == 0.0 && pcp.max == 99.0);
+        }
+    }
+
+    // tmin > tmax is counted on both variables; clip swaps the pair, mask drops it
+    for (RangeAction action : {RangeAction::Flag, RangeAction::Clip, RangeAction::Mask}) {
+        options.action = action;
+        std::vector<VariableData> data = {variable(VariableId::Tmax, {{20.0, 5.0, kFill}}),
+                                          variable(VariableId::Tmin, {{10.0, 8.0, 30.0}})};
+        std::vector<VariableQaStats> stats = QualityControl::run(data, options);
+        CHECK(stats.size() == 2 && stats[0].inconsistent == 1 && stats[1].inconsistent == 1);
+        const std::vector<double>& tmax = data[0].stations[0].data;
+        const std::vector<double>& tmin = data[1].stations[0].data;
+        if (action == RangeAction::Flag) CHECK(tmax[1] == 5.0 && tmin[1] == 8.0);
+        if (action == RangeAction::Clip) CHECK(tmax[1] == 8.0 && tmin[1] == 5.0);
+        if (action == RangeAction::Mask) CHECK(tmax[1] == kFill && tmin[1] == kFill);
+        CHECK(tmin[2] == 30.0); // no tmax that day: nothing to compare
+    }
+
+    // A variable without a single valid value reports fill for its range
+    options.action = RangeAction::Flag;
+    std::vector<VariableData> empty = {variable(VariableId::Wnd, {{-99.0, kFill}})};
+    std::vector<VariableQaStats> emptyStats = QualityControl::run(empty, options);
+    CHECK(emptyStats[0].missing == 2 && emptyStats[0].min == kFill && emptyStats[0].max == kFill);
+
+    // Merging per-block stats keeps the range of the blocks that had data
+    VariableQaStats total, part, none;
+    total.values = 4; total.min = 1.0; total.max = 3.0;
+    part.values = 2; part.sentinels = 1; part.missing = 1; part.min = -1.0; part.max = 2.0;
+    none.values = 2; none.missing = 2; none.min = none.max = kFill;
+    QualityControl::merge(total, part);
+    QualityControl::merge(total, none);
+    CHECK(total.values == 8 && total.sentinels == 1 && total.missing == 3);
+    CHECK(total.min == -1.0 && total.max == 3.0);
+
+    RangeAction parsed;
+    CHECK(parseRangeAction("mask", parsed) && parsed == RangeAction::Mask);
+    CHECK(!parseRangeAction("drop", parsed));
+    CHECK(rangeActionName(RangeAction::Clip) == "clip");
+    ValidRange range = validRange(VariableId::Tmin);
+    CHECK(range.min == -90.0 && range.max == 60.0);
+
+    Check::TempDir dir("quality");
+    std::string report = dir.file("qa_report.txt");
+    CHECK(QualityControl::writeReport(report, emptyStats, options));
+    std::ifstream in(report);
+    std::stringstream text;
+    text << in.rdbuf();
+    CHECK(text.str().find("out-of-range action: flag") != std::string::npos);
+    CHECK(text.str().find("wnd") != std::string::npos);
+    CHECK(text.str().find("valid [0.000, 75.000]") != std::string::npos);
+
+    return Check::result();
+}
@@ -0,0 +1,122 @@
+#include "Check.h"
+#include "Converter.h"
+#include "Server.h"
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SWAT2NETCDF_UNIX_SOCKETS
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool rejected(const std::string& json, const std::string& expected) {
+    ServeRequest request;
+    std::string error;
+    return !parseServeRequest(json, request, error) && error.find(expected) != std::string::npos;
+}
+
+#ifdef SWAT2NETCDF_UNIX_SOCKETS
+
+int connectTo(const std::string& socketPath) {
+    // The server thread may not be listening yet
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return fd;
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+// One reply line, or "" after five seconds
+std::string exchange(int fd, const std::string& line) {
+    std::string data = line + "\n";
+    if (send(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) return "";
+    std::string reply;
+    char c;
+    while (reply.empty() || reply.back() != '\n') {
+        pollfd readable{fd, POLLIN, 0};
+        if (poll(&readable, 1, 5000) <= 0 || recv(fd, &c, 1, 0) != 1) return "";
+        reply += c;
+    }
+    return reply;
+}
+
+#endif
+
+}
+
+int main() {
+    ServeRequest request;
+    std::string error;
+    CHECK(parseServeRequest("{\"output\": \"run7.nc4\", \"resolution\": 0.1, \"variables\": [\"pcp\", \"tmp\"]}", request, error));
+    CHECK(request.output == "run7.nc4" && request.resolution == 0.1);
+    CHECK(request.variables == std::vector<std::string>({"pcp", "tmp"}));
+    CHECK(parseServeRequest("{\"output\": \"runs/a.nc4\", \"bounds\": [40, 41, -95, -94], \"variables\": \"\"}", request, error));
+    CHECK(request.bounds.size() == 4 && request.variables.empty());
+    CHECK(parseServeRequest("{\"output\": \"r\\u0031.nc4\", \"start\": \"1990-01-01\"}", request, error) && request.output == "r1.nc4");
+
+    CHECK(rejected("[1, 2]", "not a JSON object"));
+    CHECK(rejected("{\"resolution\": 0.1}", "missing output"));
+    CHECK(rejected("{\"output\": \"a.nc4\", \"resolution\": -1}", "invalid field"));
+    CHECK(rejected("{\"output\": \"a.nc4\", \"variables\": [\"rain\"]}", "unknown variables"));
+    CHECK(rejected("{\"output\": \"a.nc4\", \"bounds\": [1, 2, 3, \"4\"]}", "bounds"));
+
+    // Outputs stay inside the output directory
+    CHECK(rejected("{\"output\": \"/tmp/a.nc4\"}", "relative to the output directory"));
+    CHECK(rejected("{\"output\": \"../a.nc4\"}", "relative to the output directory"));
+    CHECK(rejected("{\"output\": \"runs/../../a.nc4\"}", "relative to the output directory"));
+    CHECK(rejected("{\"output\": \"runs/\"}", "relative to the output directory"));
+
+    Check::TempDir dir("server");
+    Check::TempDir outside("server_outside");
+    Check::writeFile(dir.file("weather-sta.cli"),
+                     "weather-sta.cli: test\nname wgn pcp tmp slr hmd wnd wnd_dir atmo_dep\na wgn1 a.pcp null null null null null null\n");
+    Check::writeFile(dir.file("a.pcp"), Check::stationFile(0, 44.0, -93.0, 200, "1980 1 1.0\n1980 2 2.0\n"));
+    Converter converter("R", dir.path(), dir.path());
+    converter.processWeatherFiles();
+
+    // A symlinked directory does not lead out of it either
+    std::error_code ec;
+    std::filesystem::create_directory_symlink(outside.path(), dir.file("link"), ec);
+    if (!ec) {
+        ServeReply reply;
+        CHECK(parseServeRequest("{\"output\": \"link/a.nc4\"}", request, error));
+        CHECK(!converter.writeRequest(request, reply) && reply.error.find("outside the output directory") != std::string::npos);
+        CHECK(!std::filesystem::exists(outside.file("a.nc4")));
+    }
+
+#ifdef SWAT2NETCDF_UNIX_SOCKETS
+    // With one worker, an idle connection does not hold up another client
+    std::string socketPath = dir.file("R.sock");
+    bool started = false;
+    std::thread server([&] { started = Server::run(converter, socketPath, 1); });
+    int idle = connectTo(socketPath);
+    int client = connectTo(socketPath);
+    CHECK(idle >= 0 && client >= 0);
+    if (idle >= 0 && client >= 0) {
+        CHECK(exchange(client, "{\"command\": \"status\"}").find("\"pcp\": 1") != std::string::npos);
+        CHECK(exchange(client, "{\"output\": \"/tmp/a.nc4\"}").find("\"ok\": false") != std::string::npos);
+        // The idle connection is still served afterwards, by the same worker
+        CHECK(exchange(idle, "{\"command\": \"status\"}").find("\"ok\": true") != std::string::npos);
+        CHECK(exchange(client, "{\"command\": \"stop\"}") == "{\"ok\": true}\n");
+    }
+    if (idle >= 0) close(idle);
+    if (client >= 0) close(client);
+    server.join();
+    CHECK(started && !std::filesystem::exists(socketPath));
+#endif
+
+    return Check::result();
+}
@@ -0,0 +1,78 @@
+#include "Check.h"
+#include "Converter.h"
+#include "SpillStore.h"
+#include "Utils.h"
+#include <vector>
+
+namespace {
+
+const float kMissing = Converter::kMissingValue;
+
+Station station(int startDay, int startStep, const std::vector<double>& data) {
+    Station st{};
+    st.startYear = 2000;
+    st.startDay = startDay;
+    st.startStep = startStep;
+    st.data = data;
+    return st;
+}
+
+}
+
+int main() {
+    Check::TempDir dir("spill");
+
+    // 10 daily steps from 1 January 2000 in tiles of 3 steps x 2 stations
+    SpillStore store(dir.file("daily.spill"), Utils::dayIndex(2000, 1), 1, 10, 2, 3);
+    CHECK(store.addVariable(VariableId::Pcp, 5));
+    CHECK(store.has(VariableId::Pcp) && !store.has(VariableId::Tmax));
+    CHECK(store.slots(VariableId::Pcp) == 5 && store.stationBlock() == 2);
+
+    std::vector<Station> stations = {
+        station(1, 0, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}),
+        station(4, 0, {40, 41}),                            // starts on day 4
+        station(1, 0, {}),                                  // no record
+        station(9, 0, {90, 91, 92, 93}),                    // runs past the axis
+    };
+    stations[2].startYear = stations[2].startDay = -1;
+    // Written in two blocks that straddle a station block, then the last slot filled
+    store.write(VariableId::Pcp, 0, stations, 0, 3);
+    store.write(VariableId::Pcp, 3, stations, 3, 1);
+    store.fill(VariableId::Pcp, 4);
+
+    std::vector<float> out(10 * 5);
+    store.read(VariableId::Pcp, 0, 10, out.data());
+    CHECK(out[0 * 5 + 0] == 1 && out[9 * 5 + 0] == 10);
+    CHECK(out[2 * 5 + 1] == kMissing && out[3 * 5 + 1] == 40 && out[4 * 5 + 1] == 41 && out[5 * 5 + 1] == kMissing);
+    CHECK(out[0 * 5 + 2] == kMissing && out[9 * 5 + 2] == kMissing);
+    CHECK(out[8 * 5 + 3] == 90 && out[9 * 5 + 3] == 91);
+    CHECK(out[5 * 5 + 4] == kMissing);
+
+    // A window of the axis, starting inside a time tile
+    std::vector<float> window(4 * 5);
+    store.read(VariableId::Pcp, 2, 4, window.data());
+    CHECK(window[0 * 5 + 0] == 3 && window[1 * 5 + 1] == 40 && window[3 * 5 + 0] == 6);
+
+    std::vector<double> series = store.series(VariableId::Pcp, 1);
+    CHECK(series.size() == 10 && series[3] == 40 && series[0] == kMissing);
+
+    double lo = 0, hi = 0;
+    CHECK(store.bounds(VariableId::Pcp, lo, hi) && lo == 1 && hi == 91);
+    CHECK(store.addVariable(VariableId::Wnd, 1));
+    store.fill(VariableId::Wnd, 0);
+    CHECK(!store.bounds(VariableId::Wnd, lo, hi));
+    store.remove(VariableId::Wnd);
+    CHECK(!store.has(VariableId::Wnd) && store.slots(VariableId::Wnd) == 0);
+    CHECK(store.addVariable(VariableId::Wnd, 2) && store.slots(VariableId::Wnd) == 2);
+
+    // Sub-daily: a station's first step counts from the start of its day
+    SpillStore hourly(dir.file("hourly.spill"), Utils::dayIndex(2000, 1), 24, 48, 4, 16);
+    CHECK(hourly.addVariable(VariableId::Pcp, 1));
+    std::vector<Station> hours = {station(1, 22, {1, 2, 3, 4})};
+    hours[0].stepsPerDay = 24;
+    hourly.write(VariableId::Pcp, 0, hours, 0, 1);
+    std::vector<double> hourlySeries = hourly.series(VariableId::Pcp, 0);
+    CHECK(hourlySeries[21] == kMissing && hourlySeries[22] == 1 && hourlySeries[25] == 4 && hourlySeries[26] == kMissing);
+
+    return Check::result();
+}
@@ -0,0 +1,59 @@
+#include "Check.h"
+#include "Converter.h"
+#include <vector>
+
+// Hourly station records: step numbering, start step and the hourly time axis
+
+namespace {
+
+const Station* findStation(const VariableData* vd, const std::string& name) {
+    if (!vd) return nullptr;
+    for (const auto& st : vd->stations) if (st.name == name) return &st;
+    return nullptr;
+}
+
+}
+
+int main() {
+    Check::TempDir dir("subdaily");
+    Check::writeFile(dir.file("weather-sta.cli"),
+                     "weather-sta.cli: test\nname wgn pcp tmp slr hmd wnd wnd_dir atmo_dep\n"
+                     "a wgn1 a.pcp null null null null null null\n"
+                     "b wgn1 b.pcp null null null null null null\n"
+                     "c wgn1 c.pcp null null null null null null\n");
+    // 0-based from 22:00 on day 1
+    Check::writeFile(dir.file("a.pcp"), Check::stationFile(24, 44.0, -93.0, 200, "2000 1 22 1.0\n2000 1 23 2.0\n2000 2 0 3.0\n2000 2 1 4.0\n"));
+    // 1-based from the 23rd hour of day 1, up to step 24
+    Check::writeFile(dir.file("b.pcp"), Check::stationFile(24, 45.0, -92.0, 210, "2000 1 23 10.0\n2000 1 24 11.0\n2000 2 1 12.0\n"));
+    // Part of a day that shows neither step 0 nor step 24: 1-based
+    Check::writeFile(dir.file("c.pcp"), Check::stationFile(24, 44.5, -92.5, 220, "2000 1 5 100.0\n2000 1 6 101.0\n"));
+
+    Converter converter("test", dir.path(), dir.path());
+    converter.processWeatherFiles();
+    const VariableData* pcp = converter.findVariable("pcp");
+    CHECK(pcp && pcp->stations.size() == 3);
+
+    const Station* a = findStation(pcp, "a.pcp");
+    CHECK(a && a->stepsPerDay == 24 && a->startDay == 1 && a->startStep == 22);
+    CHECK(a && a->data == std::vector<double>({1.0, 2.0, 3.0, 4.0}));
+    const Station* b = findStation(pcp, "b.pcp");
+    CHECK(b && b->startStep == 22 && b->data.size() == 3);
+    const Station* c = findStation(pcp, "c.pcp");
+    CHECK(c && c->startStep == 4);
+
+    // The axis counts hours from the start of the first day, through a's last step (day 2, 01:00)
+    GridSpec grid = converter.defineGrid(0.5, false);
+    CHECK(grid.stepsPerDay == 24 && grid.startYear == 2000 && grid.startDay == 1);
+    CHECK(grid.nTime == 26);
+
+    std::vector<float> block(grid.nTime * grid.cellCount(), 0.0f);
+    CHECK(converter.gridVariable("pcp", grid, 0, grid.nTime, block.data()) == grid.nTime);
+    const size_t cells = grid.cellCount(), cellA = 1 * 5 + 1, cellB = 3 * 5 + 3, cellC = 2 * 5 + 2;
+    CHECK(block[21 * cells + cellA] == Converter::kMissingValue);
+    CHECK(block[22 * cells + cellA] == 1.0f && block[25 * cells + cellA] == 4.0f);
+    CHECK(block[22 * cells + cellB] == 10.0f && block[24 * cells + cellB] == 12.0f);
+    CHECK(block[4 * cells + cellC] == 100.0f && block[5 * cells + cellC] == 101.0f);
+    CHECK(block[6 * cells + cellC] == Converter::kMissingValue);
+
+    return Check::result();
+}
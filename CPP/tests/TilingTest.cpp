@@ -0,0 +1,100 @@
+#include "Check.h"
+#include "Converter.h"
+#include "Tiling.h"
+#include <vector>
+
+namespace {
+
+GridSpec grid(int nLat, int nLon) {
+    GridSpec g;
+    g.minLat = 40.0;
+    g.minLon = -95.0;
+    g.resolution = 0.01;
+    g.nLat = nLat;
+    g.nLon = nLon;
+    g.maxLat = g.minLat + (nLat - 1) * g.resolution;
+    g.maxLon = g.minLon + (nLon - 1) * g.resolution;
+    g.startYear = 2000;
+    g.startDay = 1;
+    g.nTime = 3650;
+    return g;
+}
+
+// Every cell in exactly one tile, tiles row-major, starts on chunk boundaries
+bool partitions(const GridSpec& g, const TileSpec& spec, const std::vector<Tile>& tiles) {
+    if (static_cast<int>(tiles.size()) != spec.count()) return false;
+    std::vector<int> owner(g.cellCount(), 0);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const Tile& t = tiles[i];
+        if (t.index != static_cast<int>(i) || t.latStart % t.chunkLat != 0 || t.lonStart % t.chunkLon != 0) return false;
+        for (int lat = t.latStart; lat < t.latStart + t.latCount; ++lat) {
+            for (int lon = t.lonStart; lon < t.lonStart + t.lonCount; ++lon) owner[static_cast<size_t>(lat) * g.nLon + lon]++;
+        }
+    }
+    for (int count : owner) if (count != 1) return false;
+    return true;
+}
+
+}
+
+int main() {
+    TileSpec spec;
+    CHECK(!spec.enabled() && spec.count() == 1);
+    CHECK(parseTileLayout("4x8", spec) && spec.rows == 4 && spec.cols == 8 && spec.enabled());
+    CHECK(parseTileLayout("2X3", spec) && spec.rows == 2 && spec.cols == 3);
+    CHECK(!parseTileLayout("4", spec));
+    CHECK(!parseTileLayout("0x2", spec));
+    CHECK(!parseTileLayout("2x3x", spec));
+
+    // --tile keeps a matching --tiles layout, otherwise picks the squarest one
+    CHECK(parseTileIndex("5/6", spec) && spec.rows == 2 && spec.cols == 3 && spec.index == 4);
+    TileSpec fresh;
+    CHECK(parseTileIndex("1/12", fresh) && fresh.rows == 3 && fresh.cols == 4 && fresh.index == 0);
+    CHECK(parseTileIndex("7/7", fresh) && fresh.rows == 1 && fresh.cols == 7);
+    CHECK(!parseTileIndex("0/4", fresh));
+    CHECK(!parseTileIndex("5/4", fresh));
+    CHECK(!parseTileIndex("2", fresh));
+
+    // 1000 x 700 in 3 x 2 tiles: two chunks of 167 rows and 175 columns per tile
+    GridSpec g = grid(1000, 700);
+    TileSpec layout;
+    layout.rows = 3;
+    layout.cols = 2;
+    std::vector<Tile> tiles = gridTiles(g, layout);
+    CHECK(partitions(g, layout, tiles));
+    if (tiles.size() == 6) {
+        CHECK(tiles[0].chunkLat == 167 && tiles[0].chunkLon == 175);
+        CHECK(tiles[5].latStart == 668 && tiles[5].latCount == 332 && tiles[5].lonStart == 350);
+    }
+
+    // Other shapes, including ones where rounding up to chunks could empty the last tile
+    for (int nLat : {1, 7, 255, 256, 257, 513, 999}) {
+        for (int rows : {1, 2, 3, 5}) {
+            TileSpec s;
+            s.rows = rows;
+            s.cols = 2;
+            GridSpec shape = grid(nLat, 300);
+            std::vector<Tile> result = gridTiles(shape, s);
+            CHECK(result.empty() || partitions(shape, s, result));
+            if (rows > nLat) CHECK(result.empty());
+        }
+    }
+
+    // A tile is a grid of its own on the same lattice
+    if (tiles.size() == 6) {
+        GridSpec local = tileGrid(g, tiles[3]);
+        CHECK(local.nLat == tiles[3].latCount && local.nLon == tiles[3].lonCount);
+        CHECK_NEAR(local.minLat, g.minLat + tiles[3].latStart * g.resolution, 1e-9);
+        CHECK_NEAR(local.minLon, g.minLon + tiles[3].lonStart * g.resolution, 1e-9);
+        CHECK(local.nTime == g.nTime && local.startYear == g.startYear);
+
+        std::vector<size_t> chunks = tileChunking(tiles[3], g.nTime);
+        CHECK(chunks.size() == 3 && chunks[1] == 167 && chunks[2] == 175);
+        CHECK(chunks[0] * chunks[1] * chunks[2] * sizeof(float) <= 4 * 1024 * 1024);
+        CHECK(tileChunking(tiles[3], 5)[0] == 5);
+    }
+
+    CHECK(tileFileName("R", 0, 6) == "R_tile1of6.nc4");
+
+    return Check::result();
+}
@@ -0,0 +1,96 @@
+#include "Check.h"
+#include "Converter.h"
+#include "TimeShards.h"
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Daily axis from 27 October 1999 (day 300) to 10 January 2001
+GridSpec axis(int stepsPerDay) {
+    GridSpec grid;
+    grid.startYear = 1999;
+    grid.startDay = 300;
+    grid.stepsPerDay = stepsPerDay;
+    grid.nTime = static_cast<size_t>(66 + 366 + 10) * stepsPerDay;
+    return grid;
+}
+
+bool covers(const std::vector<TimeShard>& shards, size_t nTime) {
+    size_t t = 0;
+    for (const auto& shard : shards) {
+        if (shard.timeStart != t || shard.timeCount == 0) return false;
+        t += shard.timeCount;
+    }
+    return t == nTime;
+}
+
+}
+
+int main() {
+    ShardSpec spec;
+    CHECK(parseShardSpec("year", spec) && spec.mode == ShardSpec::Year);
+    CHECK(parseShardSpec("decade", spec) && spec.mode == ShardSpec::Decade);
+    CHECK(parseShardSpec("100", spec) && spec.mode == ShardSpec::Days && spec.days == 100);
+    CHECK(!parseShardSpec("0", spec));
+    CHECK(!parseShardSpec("10d", spec));
+    CHECK(!parseShardSpec("month", spec));
+
+    GridSpec grid = axis(1);
+    ShardSpec none;
+    std::vector<TimeShard> whole = timeShards(grid, none);
+    CHECK(whole.size() == 1 && whole[0].timeCount == grid.nTime);
+
+    // Calendar years: a partial first year, the leap year 2000, a partial last year
+    spec.mode = ShardSpec::Year;
+    std::vector<TimeShard> years = timeShards(grid, spec);
+    CHECK(years.size() == 3 && covers(years, grid.nTime));
+    if (years.size() == 3) {
+        CHECK(years[0].label == "1999" && years[0].timeCount == 66);
+        CHECK(years[1].label == "2000" && years[1].timeCount == 366);
+        CHECK(years[2].label == "2001" && years[2].timeCount == 10);
+    }
+
+    spec.mode = ShardSpec::Decade;
+    std::vector<TimeShard> decades = timeShards(grid, spec);
+    CHECK(decades.size() == 2 && covers(decades, grid.nTime));
+    if (decades.size() == 2) {
+        CHECK(decades[0].label == "1990s" && decades[0].timeCount == 66);
+        CHECK(decades[1].label == "2000s" && decades[1].timeCount == 376);
+    }
+
+    // Fixed lengths are labelled with their first and last dates
+    spec.mode = ShardSpec::Days;
+    spec.days = 200;
+    std::vector<TimeShard> blocks = timeShards(grid, spec);
+    CHECK(blocks.size() == 3 && covers(blocks, grid.nTime));
+    if (blocks.size() == 3) {
+        CHECK(blocks[0].label == "1999-10-27_2000-05-13");
+        CHECK(blocks[2].timeCount == 42);
+    }
+
+    // Sub-daily axes split on the same day boundaries
+    GridSpec hourly = axis(24);
+    spec.mode = ShardSpec::Year;
+    std::vector<TimeShard> hourlyYears = timeShards(hourly, spec);
+    CHECK(hourlyYears.size() == 3 && covers(hourlyYears, hourly.nTime));
+    if (hourlyYears.size() == 3) CHECK(hourlyYears[1].timeStart == 66 * 24 && hourlyYears[1].timeCount == 366 * 24);
+    spec.mode = ShardSpec::Days;
+    std::vector<TimeShard> hourlyBlocks = timeShards(hourly, spec);
+    CHECK(!hourlyBlocks.empty() && hourlyBlocks[0].timeCount == 200 * 24 && hourlyBlocks[0].label == blocks[0].label);
+
+    // No time axis, no shards
+    GridSpec empty;
+    CHECK(timeShards(empty, spec).empty());
+
+    Check::TempDir dir("shards");
+    std::string index = dir.file("R.ncml");
+    CHECK(writeShardIndex(index, years, {"R_1999.nc4", "R_2000.nc4", "R_2001.nc4"}));
+    std::ifstream in(index);
+    std::stringstream text;
+    text << in.rdbuf();
+    CHECK(text.str().find("type=\"joinExisting\"") != std::string::npos);
+    CHECK(text.str().find("<netcdf location=\"R_2000.nc4\" ncoords=\"366\"/>") != std::string::npos);
+
+    return Check::result();
+}
@@ -0,0 +1,91 @@
+#include "Check.h"
+#include "Converter.h"
+#include "Utils.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --variables and the file.cio climate line: which groups are read, and what netcdf.ncw and file.cio say about the rest
+
+namespace {
+
+const std::string kClimate =
+    "climate           weather-sta.cli   weather-wgn.cli   null              pcp.cli           null              null              null              wnd.cli           null\n";
+
+std::string readText(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+void writeTxtInOut(const Check::TempDir& dir) {
+    Check::writeFile(dir.file("file.cio"), "file.cio: test\nsimulation        time.sim          print.prt\n" + kClimate +
+                                               "pcp_path          null\ntmp_path          null\n");
+    Check::writeFile(dir.file("weather-sta.cli"),
+                     "weather-sta.cli: test\nname wgn pcp tmp slr hmd wnd wnd_dir atmo_dep\n"
+                     "a wgn1 a.pcp a.tmp null null a.wnd null null\n");
+    Check::writeFile(dir.file("a.pcp"), Check::stationFile(0, 44.0, -93.0, 200, "1980 1 1.0\n1980 2 2.0\n"));
+    Check::writeFile(dir.file("a.tmp"), Check::stationFile(0, 44.0, -93.0, 200, "1980 1 25.0 10.0\n1980 2 26.0 11.0\n"));
+    Check::writeFile(dir.file("a.wnd"), Check::stationFile(0, 44.0, -93.0, 200, "1980 1 3.0\n1980 2 4.0\n"));
+}
+
+}
+
+int main() {
+    std::vector<std::string> groups;
+    CHECK(Utils::parseVariableList("pcp,tmp", groups) && groups == std::vector<std::string>({"pcp", "tmp"}));
+    CHECK(Utils::parseVariableList("wnd,,pcp,wnd", groups) && groups == std::vector<std::string>({"wnd", "pcp"}));
+    CHECK(!Utils::parseVariableList("pcp,tmax", groups));
+    CHECK(!Utils::parseVariableList(",", groups));
+
+    // Climate line entries: pet, pcp, tmp, slr, hmd, wnd; an already converted file.cio selects nothing
+    CHECK(Utils::parseClimateVariables("file.cio: test\n" + kClimate) == std::vector<std::string>({"pcp", "wnd"}));
+    CHECK(Utils::parseClimateVariables("climate netcdf.ncw weather-wgn.cli null null null null null null null\n").empty());
+    CHECK(Utils::parseClimateVariables("simulation time.sim\n").empty());
+
+    Check::TempDir dir("selection");
+    writeTxtInOut(dir);
+    CHECK(Utils::climateVariables(dir.path()) == std::vector<std::string>({"pcp", "wnd"}));
+
+    // Unselected groups fall back to the weather generator in file.cio
+    Utils::updateFileCIO(dir.path(), dir.path(), "R", {"pcp"});
+    std::string cio = readText(dir.file("file.cio"));
+    CHECK(cio.find("pcp_path          R.nc4") != std::string::npos);
+    CHECK(cio.find("tmp_path          null") != std::string::npos);
+    CHECK(cio.find("climate           netcdf.ncw") != std::string::npos);
+    writeTxtInOut(dir);
+
+    Converter converter("R", dir.path(), dir.path());
+    converter.setVariables({"pcp", "tmp", "wnd"});
+    converter.processWeatherFiles();
+    CHECK(converter.findVariable("pcp") && converter.findVariable("tmax") && converter.findVariable("wnd"));
+    CHECK(converter.isSelected("tmp") && !converter.isSelected("slr"));
+
+    // Narrowing after loading drops the series of groups no longer selected
+    converter.restrictVariables({"pcp"});
+    CHECK(converter.variables() == std::vector<std::string>({"pcp"}));
+    CHECK(converter.findVariable("pcp") != nullptr);
+    CHECK(converter.findVariable("tmax") == nullptr && converter.findVariable("tmin") == nullptr);
+    CHECK(converter.findVariable("wnd") == nullptr);
+
+    // netcdf.ncw keeps the station but marks only the selected columns
+    converter.createStationListFile();
+    std::istringstream ncw(readText(dir.file("netcdf.ncw")));
+    std::string line, header, row;
+    std::getline(ncw, line);
+    std::getline(ncw, header);
+    std::getline(ncw, row);
+    std::istringstream names(header), values(row);
+    std::vector<std::string> columns, fields;
+    for (std::string field; names >> field;) columns.push_back(field);
+    for (std::string field; values >> field;) fields.push_back(field);
+    CHECK(columns.size() == fields.size() && !fields.empty() && fields[0] == "a");
+    for (size_t c = 0; c < columns.size() && c < fields.size(); ++c) {
+        if (columns[c] == "pcp") CHECK(fields[c] == "1.0");
+        if (columns[c] == "tmax" || columns[c] == "wnd") CHECK(fields[c] == "null");
+    }
+
+    return Check::result();
+}
@@ -0,0 +1,40 @@
+#include "Check.h"
+#include "Variables.h"
+#include <set>
+#include <string>
+
+int main() {
+    CHECK(Variables::consistent());
+    CHECK(Variables::kGroupCount == 6 && Variables::kVariableCount == 7);
+    CHECK(Variables::kMaxColumns == 2);
+
+    // Enum-indexed access and name lookups agree
+    for (const auto& v : Variables::kVariables) {
+        CHECK(Variables::variable(v.id).name == v.name);
+        CHECK(Variables::findVariable(v.name) == &Variables::variable(v.id));
+        CHECK(Variables::group(v.group).columns > v.column);
+    }
+    for (const auto& g : Variables::kGroups) {
+        CHECK(Variables::findGroup(g.name) == &Variables::group(g.id));
+    }
+    CHECK(Variables::findVariable("snow") == nullptr);
+    CHECK(Variables::findGroup("tmax") == nullptr);  // a variable, not a group
+    CHECK(Variables::findVariable("tmp") == nullptr); // a group, not a variable
+
+    // Temperature rows carry tmax then tmin; .tem files take precedence over .tmp
+    const GroupDescriptor& tmp = Variables::group(WeatherGroup::Tmp);
+    CHECK(std::string(tmp.extension) == ".tmp" && std::string(tmp.preferredExtension) == ".tem");
+    CHECK(Variables::variable(VariableId::Tmax).column == 0 && Variables::variable(VariableId::Tmin).column == 1);
+
+    // netcdf.ncw and file.cio positions are permutations
+    std::set<int> ncw, climate;
+    for (const auto& v : Variables::kVariables) ncw.insert(v.ncwColumn);
+    for (const auto& g : Variables::kGroups) climate.insert(g.climateColumn);
+    CHECK(ncw.size() == Variables::kVariableCount && *ncw.rbegin() == static_cast<int>(Variables::kVariableCount) - 1);
+    CHECK(climate.size() == Variables::kGroupCount && *climate.rbegin() == static_cast<int>(Variables::kGroupCount) - 1);
+
+    // Only PET waits to be loaded before netcdf.ncw marks it
+    for (const auto& v : Variables::kVariables) CHECK(v.ncwIfLoaded == (v.id == VariableId::Pet));
+
+    return Check::result();
+}